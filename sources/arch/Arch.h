@@ -21,12 +21,64 @@ void idle() __noreturn;
 
 void halt();
 
-void yield();
+// Save the registers of `from` on its stack and resume `to` from where it
+// was, must be called with interrupts disabled. It only returns once `from`
+// is switched back to.
+void switch_context(system::tasking::Thread &from, system::tasking::Thread &to);
+
+// Disable interrupts on the current cpu, return true if they were enabled.
+bool disable_interrupts();
+
+void restore_interrupts(bool were_enabled);
+
+int get_current_cpu();
+
+// Interrupt an other cpu, so it runs the scheduler even if it is idle.
+void kick_cpu(int cpu);
+
+// Ticks elapsed since boot, according to the clock of the machine.
+uint64_t clock_ticks();
+
+// A counter finer than the ticks, to account for where the time goes. Its
+// value may differ a little between cpus.
+uint64_t clock_cycles();
+
+// Zero until the speed of the counter is known.
+uint32_t clock_cycles_per_tick();
+
+// Let the current cpu sleep until the tick `until` while it is idle, instead
+// of being interrupted on every tick. Not every machine can do it.
+void stop_tick(uint64_t until);
+
+void start_tick();
 
 size_t get_page_size();
 
 system::memory::MemoryRegion get_kernel_region();
 
+// Physical memory at the bottom of the address space which is never
+// allocated, it always include the first page so nullptr stays invalid.
+system::memory::MemoryRegion get_reserved_low_region();
+
+// Physical memory the kernel can access at the same virtual address, in
+// every address space. Nothing outside of it is ever allocated.
+system::memory::MemoryRegion get_direct_map_region();
+
+// Virtual memory, shared by every address space, where kernel stacks are
+// mapped. Anything which isn't mapped there faults.
+system::memory::MemoryRegion get_kernel_stack_region();
+
+// Map a page of the kernel stack region, it stays mapped forever.
+void map_kernel_stack_page(uintptr_t virtual_address, uintptr_t physical_address);
+
+// Free a region which was mapped in userspace, as soon as no cpu could still
+// be reaching it through a stale TLB entry.
+void free_unmapped_region(system::memory::MemoryRegion region);
+
+// Wait until no cpu could still be reaching what was unmapped so far through
+// a stale TLB entry. No lock may be held, the other cpus may need it to get there.
+void wait_unmapped_regions();
+
 libruntime::RefPtr<system::tasking::Thread> create_thread(
     libruntime::RefPtr<system::tasking::Process> process,
     system::tasking::ThreadEntry entry);
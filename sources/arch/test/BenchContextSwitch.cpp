@@ -0,0 +1,251 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+// Yield ping-pong between two contexts, switching like the kernel does on a
+// voluntary yield: before, through a full interrupt frame, and now, with
+// switch_stack() which only saves the callee-saved registers.
+//
+// This is the x86_64 version of both paths, run in userspace. The interrupt
+// path is emulated: the frame the cpu would push is built by hand, only DS
+// and ES are reloaded, as FS holds the TLS of the host, and there is no `int`
+// nor end of interrupt, so the real gap is wider than what is measured here.
+// Boot the kernel with BUILD_BENCH_YIELD=yes to measure it on a real switch.
+//
+// Build from the root of the repository with:
+//   g++ -std=c++17 -O2 sources/arch/test/BenchContextSwitch.cpp
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#if !defined(__x86_64__)
+#    error "This bench only runs on x86_64 hosts."
+#endif
+
+#define BENCH_ITERATIONS 10000000
+#define BENCH_STACK_SIZE 16384
+
+extern "C" void coop_switch(uintptr_t *from, uintptr_t to);
+extern "C" void frame_switch(uintptr_t *from, uintptr_t to);
+
+asm(R"(
+    .text
+
+    .global coop_switch
+coop_switch:
+    push %rbp
+    push %rbx
+    push %r12
+    push %r13
+    push %r14
+    push %r15
+
+    mov %rsp, (%rdi)
+    mov %rsi, %rsp
+
+    pop %r15
+    pop %r14
+    pop %r13
+    pop %r12
+    pop %rbx
+    pop %rbp
+
+    ret
+
+    .global frame_switch
+frame_switch:
+    pop %r11
+    mov %rsp, %rax
+
+    mov %ss, %ecx
+    push %rcx
+    push %rax
+    pushfq
+    mov %cs, %ecx
+    push %rcx
+    push %r11
+
+    push $0
+    push $0
+
+    push %rax
+    push %rcx
+    push %rdx
+    push %rbx
+    push %rbp
+    push %rsi
+    push %rdi
+    push %r8
+    push %r9
+    push %r10
+    push %r11
+    push %r12
+    push %r13
+    push %r14
+    push %r15
+
+    mov %ds, %eax
+    push %rax
+    mov %es, %eax
+    push %rax
+
+    mov %ds, %eax
+    mov %eax, %ds
+    mov %eax, %es
+
+    mov %rsp, (%rdi)
+    mov %rsi, %rsp
+
+frame_return:
+    pop %rax
+    mov %eax, %es
+    pop %rax
+    mov %eax, %ds
+
+    pop %r15
+    pop %r14
+    pop %r13
+    pop %r12
+    pop %r11
+    pop %r10
+    pop %r9
+    pop %r8
+    pop %rdi
+    pop %rsi
+    pop %rbp
+    pop %rbx
+    pop %rdx
+    pop %rcx
+    pop %rax
+
+    add $16, %rsp
+
+    iretq
+)");
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uintptr_t _main_stack;
+static uintptr_t _other_stack;
+static volatile size_t _switches;
+alignas(16) static uint8_t _stack[BENCH_STACK_SIZE];
+
+// The entry is "returned" to, so its stack must look like it was called.
+static uintptr_t *stack_top()
+{
+    auto *top = reinterpret_cast<uintptr_t *>(_stack + BENCH_STACK_SIZE);
+
+    *--top = 0;
+
+    return top;
+}
+
+static void coop_entry()
+{
+    while (true)
+    {
+        _switches++;
+        coop_switch(&_other_stack, _main_stack);
+    }
+}
+
+static void frame_entry()
+{
+    while (true)
+    {
+        _switches++;
+        frame_switch(&_other_stack, _main_stack);
+    }
+}
+
+static void prepare_coop()
+{
+    uintptr_t *top = stack_top();
+
+    *--top = reinterpret_cast<uintptr_t>(coop_entry);
+
+    // rbp, rbx, r12, r13, r14 and r15.
+    for (int i = 0; i < 6; i++)
+    {
+        *--top = 0;
+    }
+
+    _other_stack = reinterpret_cast<uintptr_t>(top);
+}
+
+static void prepare_frame()
+{
+    uintptr_t *top = stack_top();
+    uintptr_t entry_stack = reinterpret_cast<uintptr_t>(top);
+
+    uint64_t ss, cs, ds, es, flags;
+    asm volatile("mov %%ss, %0" : "=r"(ss));
+    asm volatile("mov %%cs, %0" : "=r"(cs));
+    asm volatile("mov %%ds, %0" : "=r"(ds));
+    asm volatile("mov %%es, %0" : "=r"(es));
+    asm volatile("pushfq; pop %0" : "=r"(flags));
+
+    *--top = ss;
+    *--top = entry_stack;
+    *--top = flags;
+    *--top = cs;
+    *--top = reinterpret_cast<uintptr_t>(frame_entry);
+
+    // The interrupt number and the error code, then the 15 registers.
+    for (int i = 0; i < 2 + 15; i++)
+    {
+        *--top = 0;
+    }
+
+    *--top = ds;
+    *--top = es;
+
+    _other_stack = reinterpret_cast<uintptr_t>(top);
+}
+
+template <typename Switch>
+static void bench(const char *name, Switch switch_stack)
+{
+    _switches = 0;
+
+    uint64_t start = now_ns();
+
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        switch_stack(&_main_stack, _other_stack);
+    }
+
+    uint64_t elapsed = now_ns() - start;
+
+    assert(_switches == BENCH_ITERATIONS);
+
+    // There and back again.
+    size_t switches = 2 * BENCH_ITERATIONS;
+
+    printf("%-10s %8.1f ns/switch %10.1f Mswitch/s\n",
+           name,
+           static_cast<double>(elapsed) / switches,
+           switches * 1000.0 / elapsed);
+}
+
+int main(int argc, char const *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    prepare_frame();
+    bench("interrupt", frame_switch);
+
+    prepare_coop();
+    bench("switch", coop_switch);
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+// Compare the pool and the buddy backends of the physical memory allocator on
+// a synthetic fragmented memory map.
+//
+// Build from the root of the repository with:
+//   g++ -std=c++17 -O2 -I. -Isources -Isources/libraries sources/arch/test/BenchMemoryAllocator.cpp
+
+#include <assert.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#include "arch/Arch.h"
+#include "system/memory/MemoryBuddy.cpp"
+#include "system/memory/MemoryPool.cpp"
+#include "system/memory/MemoryRegion.cpp"
+
+using system::memory::MemoryBuddy;
+using system::memory::MemoryPool;
+using system::memory::MemoryRegion;
+
+#define BENCH_MEMORY_SIZE (256 * 1024 * 1024)
+#define BENCH_LIVE_REGIONS 512
+#define BENCH_ITERATIONS 200000
+
+size_t arch::get_page_size()
+{
+    return 4096;
+}
+
+// MemoryRegion is formattable, but nothing is ever printed through libsystem here.
+libruntime::ErrorOr<size_t> libsystem::format(Stream &, const char *)
+{
+    return 0ul;
+}
+
+libruntime::ErrorOr<size_t> libsystem::format(Stream &, uint, FormatInfo &)
+{
+    return 0ul;
+}
+
+libruntime::ErrorOr<size_t> libsystem::format(Stream &, void *, FormatInfo &)
+{
+    return 0ul;
+}
+
+static uint32_t _random_state;
+
+static uint32_t random_next()
+{
+    _random_state ^= _random_state << 13;
+    _random_state ^= _random_state >> 17;
+    _random_state ^= _random_state << 5;
+
+    return _random_state;
+}
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Free the span as a lot of small extents separated by holes, like a
+// multiboot map full of reserved ranges would look like.
+template <typename Allocator>
+static size_t populate(Allocator &allocator, MemoryRegion span)
+{
+    size_t extents = 0;
+    uintptr_t page = span.base_page();
+
+    _random_state = 0xdeadbeef;
+
+    while (page < span.end_page())
+    {
+        size_t lenght = 1 + random_next() % 64;
+        size_t hole = 1 + random_next() % 8;
+
+        if (page + lenght > span.end_page())
+        {
+            lenght = span.end_page() - page;
+        }
+
+        allocator.put(MemoryRegion::from_page(page, lenght));
+
+        page += lenght + hole;
+        extents++;
+    }
+
+    return extents;
+}
+
+template <typename Allocator>
+static void bench(const char *name, Allocator &allocator, MemoryRegion span)
+{
+    static const size_t sizes[] = {1, 1, 1, 2, 4, 16, 16, 32};
+
+    size_t extents = populate(allocator, span);
+    size_t initial_quantity = allocator.quantity();
+
+    MemoryRegion live[BENCH_LIVE_REGIONS];
+    size_t failled = 0;
+
+    _random_state = 0xcafebabe;
+
+    uint64_t start = now_ns();
+
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        MemoryRegion &slot = live[random_next() % BENCH_LIVE_REGIONS];
+
+        if (!slot.is_empty())
+        {
+            allocator.put(slot);
+            slot = MemoryRegion::empty();
+        }
+        else
+        {
+            slot = allocator.take(sizes[random_next() % (sizeof(sizes) / sizeof(sizes[0]))]);
+
+            if (slot.is_empty())
+            {
+                failled++;
+            }
+        }
+    }
+
+    uint64_t elapsed = now_ns() - start;
+
+    for (size_t i = 0; i < BENCH_LIVE_REGIONS; i++)
+    {
+        allocator.put(live[i]);
+    }
+
+    assert(allocator.quantity() == initial_quantity);
+
+    printf("%-6s %6zu extents %8zu pages free %10.1f ns/op (%zu failled)\n",
+           name, extents, initial_quantity,
+           static_cast<double>(elapsed) / BENCH_ITERATIONS, failled);
+}
+
+int main(int argc, char const *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    void *memory = mmap(nullptr, BENCH_MEMORY_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(memory != MAP_FAILED);
+
+    MemoryRegion span = MemoryRegion::from_aligned_address(reinterpret_cast<uintptr_t>(memory), BENCH_MEMORY_SIZE);
+
+    MemoryPool pool{};
+    bench("pool", pool, span);
+
+    uint8_t *bitmap = new uint8_t[MEMORY_BUDDY_BITMAP_SIZE(span.page_count())];
+    MemoryBuddy buddy{span, bitmap};
+    bench("buddy", buddy, span);
+
+    delete[] bitmap;
+    munmap(memory, BENCH_MEMORY_SIZE);
+
+    return 0;
+}
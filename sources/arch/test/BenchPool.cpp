@@ -0,0 +1,168 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+// Compare what a context switch pay in allocations (the ready queue node
+// going in and out, and a blocker now and then) between the kernel heap and
+// libruntime::Pool.
+//
+// Build from the root of the repository with:
+//   g++ -std=c++17 -O2 -I. -Isources -Isources/libraries sources/arch/test/BenchPool.cpp
+
+#include <assert.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#include <libsystem/Logger.h>
+
+// Nothing is ever logged by the heap in this bench.
+#undef logger_error
+#undef logger_fatal
+#define logger_error(__args...)
+#define logger_fatal(__args...)
+
+#include <libruntime/LinkedList.h>
+#include <libruntime/RefCounted.h>
+#include <libruntime/RefPtr.h>
+#include <libsystem/__alloc__.cpp>
+
+#include "system/scheduling/Blocker.h"
+
+using namespace libruntime;
+
+#define BENCH_ITERATIONS 10000000
+
+void libsystem::__assert_not_reached_reached(const char *, int)
+{
+    __builtin_trap();
+}
+
+size_t __plugs__::get_page_size()
+{
+    return 4096;
+}
+
+void __plugs__::memory_lock() {}
+
+void __plugs__::memory_unlock() {}
+
+libruntime::ErrorOr<uintptr_t> __plugs__::memory_alloc(size_t how_many_pages)
+{
+    void *memory = mmap(nullptr, how_many_pages * 4096, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(memory != MAP_FAILED);
+
+    return reinterpret_cast<uintptr_t>(memory);
+}
+
+void __plugs__::memory_free(uintptr_t addr, size_t how_many_pages)
+{
+    munmap(reinterpret_cast<void *>(addr), how_many_pages * 4096);
+}
+
+bool __plugs__::interrupts_disable()
+{
+    return false;
+}
+
+void __plugs__::interrupts_restore(bool) {}
+
+size_t __plugs__::current_cpu()
+{
+    return 0;
+}
+
+struct Thread : public RefCounted<Thread>
+{
+};
+
+// Like the global operator new and delete of the kernel.
+struct HeapAllocated
+{
+    static void *operator new(size_t size) { return __alloc__::malloc(size); }
+    static void operator delete(void *ptr) { __alloc__::free(ptr); }
+};
+
+struct HeapNode : public HeapAllocated
+{
+    RefPtr<Thread> value;
+    HeapNode *prev;
+    HeapNode *next;
+
+    HeapNode(RefPtr<Thread> value) : value(value), prev(nullptr), next(nullptr) {}
+};
+
+struct BenchBlocker : public system::scheduling::Blocker
+{
+    uint32_t wakeup_tick;
+
+    system::scheduling::BlockerType type() { return system::scheduling::BlockerType::SLEEP; }
+    bool should_unblock() { return true; }
+    void unblock() {}
+};
+
+struct HeapBlocker : public BenchBlocker, public HeapAllocated
+{
+};
+
+struct PooledBlocker : public BenchBlocker, public Pooled<PooledBlocker>
+{
+};
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+template <typename Callback>
+static void bench(const char *name, Callback callback)
+{
+    uint64_t start = now_ns();
+
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        callback(i);
+    }
+
+    uint64_t elapsed = now_ns() - start;
+
+    printf("%-24s %6.1f ns/switch\n", name, static_cast<double>(elapsed) / BENCH_ITERATIONS);
+}
+
+int main(int argc, char const *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    RefPtr<Thread> thread = make<Thread>();
+
+    // Every switch queue the previous thread and dequeue the next one, one
+    // in sixteen also block it.
+    bench("kernel heap", [&](size_t i) {
+        HeapNode *item = new HeapNode(thread);
+        delete item;
+
+        if (i % 16 == 0)
+        {
+            delete new HeapBlocker();
+        }
+    });
+
+    bench("libruntime::Pool", [&](size_t i) {
+        LinkedListItem<RefPtr<Thread>> *item = new LinkedListItem<RefPtr<Thread>>(thread);
+        delete item;
+
+        if (i % 16 == 0)
+        {
+            delete new PooledBlocker();
+        }
+    });
+
+    assert(thread.refcount() == 1);
+    assert((Pooled<LinkedListItem<RefPtr<Thread>>>::pool().used() == 0));
+
+    return 0;
+}
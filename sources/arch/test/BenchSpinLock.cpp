@@ -0,0 +1,199 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+// Compare the throughput and the fairness of the spin locks of libruntime when
+// every thread is hammering the same lock.
+//
+// With more threads than cpus the fair locks fall apart, the next in line is
+// often not running. That can't happen in the kernel, where they are held
+// with interrupts disabled.
+//
+// Build from the root of the repository with:
+//   g++ -std=c++17 -O2 -pthread -I. -Isources -Isources/libraries sources/arch/test/BenchSpinLock.cpp
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <libruntime/McsLock.h>
+#include <libruntime/SpinLock.h>
+#include <libruntime/TicketLock.h>
+
+using namespace libruntime;
+
+#define BENCH_MAX_THREADS 16
+#define BENCH_DURATION_NS 200000000ull
+
+// A bit of work inside and outside of the lock, so the critical section
+// isn't just a cache line bouncing around.
+#define BENCH_WORK_INSIDE 16
+#define BENCH_WORK_OUTSIDE 64
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void work(size_t how_much)
+{
+    for (size_t i = 0; i < how_much; i++)
+    {
+        asm volatile("" ::: "memory");
+    }
+}
+
+// Give every lock the same interface, the MCS node lives on the stack of the waiter.
+struct BenchSpinLock
+{
+    SpinLock lock;
+
+    void run(volatile size_t &counter)
+    {
+        lock.acquire();
+        counter++;
+        work(BENCH_WORK_INSIDE);
+        lock.release();
+    }
+};
+
+struct BenchTicketLock
+{
+    TicketLock lock;
+
+    void run(volatile size_t &counter)
+    {
+        lock.acquire();
+        counter++;
+        work(BENCH_WORK_INSIDE);
+        lock.release();
+    }
+};
+
+struct BenchMcsLock
+{
+    McsLock lock;
+
+    void run(volatile size_t &counter)
+    {
+        McsLock::Node node;
+
+        lock.acquire(node);
+        counter++;
+        work(BENCH_WORK_INSIDE);
+        lock.release(node);
+    }
+};
+
+template <typename Lock>
+struct Bench
+{
+    Lock lock{};
+    volatile size_t counter = 0;
+    size_t ready = 0;
+    volatile bool started = false;
+    volatile bool stopped = false;
+    size_t done[BENCH_MAX_THREADS] = {};
+};
+
+template <typename Lock>
+static void *worker(void *arg)
+{
+    auto *bench = reinterpret_cast<Bench<Lock> *>(arg);
+    size_t index = __atomic_fetch_add(&bench->ready, 1, __ATOMIC_RELAXED);
+    size_t done = 0;
+
+    while (!bench->started)
+    {
+        cpu_relax();
+    }
+
+    while (!bench->stopped)
+    {
+        bench->lock.run(bench->counter);
+        work(BENCH_WORK_OUTSIDE);
+        done++;
+    }
+
+    bench->done[index] = done;
+
+    return nullptr;
+}
+
+template <typename Lock>
+static void bench(const char *name, size_t thread_count)
+{
+    auto *bench = new Bench<Lock>();
+    pthread_t threads[BENCH_MAX_THREADS];
+
+    for (size_t i = 0; i < thread_count; i++)
+    {
+        pthread_create(&threads[i], nullptr, worker<Lock>, bench);
+    }
+
+    while (__atomic_load_n(&bench->ready, __ATOMIC_RELAXED) < thread_count)
+    {
+        cpu_relax();
+    }
+
+    uint64_t start = now_ns();
+    bench->started = true;
+
+    while (now_ns() - start < BENCH_DURATION_NS)
+    {
+        struct timespec ts = {0, 1000000};
+        nanosleep(&ts, nullptr);
+    }
+
+    bench->stopped = true;
+
+    for (size_t i = 0; i < thread_count; i++)
+    {
+        pthread_join(threads[i], nullptr);
+    }
+
+    uint64_t elapsed = now_ns() - start;
+
+    size_t total = 0;
+    size_t least = (size_t)-1;
+    size_t most = 0;
+
+    for (size_t i = 0; i < thread_count; i++)
+    {
+        total += bench->done[i];
+        least = bench->done[i] < least ? bench->done[i] : least;
+        most = bench->done[i] > most ? bench->done[i] : most;
+    }
+
+    assert(total == bench->counter);
+
+    printf("%-7s %2zu threads %10.1f Mop/s  %8.1f ns/op  min/max %.2f\n",
+           name, thread_count,
+           total * 1000.0 / elapsed,
+           static_cast<double>(elapsed) / total,
+           most ? static_cast<double>(least) / most : 0.0);
+
+    delete bench;
+}
+
+int main(int argc, char const *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    static const size_t thread_counts[] = {1, 2, 4, 8, BENCH_MAX_THREADS};
+
+    for (size_t thread_count : thread_counts)
+    {
+        bench<BenchSpinLock>("spin", thread_count);
+        bench<BenchTicketLock>("ticket", thread_count);
+        bench<BenchMcsLock>("mcs", thread_count);
+        printf("\n");
+    }
+
+    return 0;
+}
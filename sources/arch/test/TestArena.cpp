@@ -0,0 +1,123 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+// Build from the root of the repository with:
+//   g++ -std=c++17 -O2 -I. -Isources -Isources/libraries sources/arch/test/TestArena.cpp sources/arch/test/__plugs__.cpp
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <libruntime/Arena.h>
+#include <libruntime/Macros.h>
+#include <libruntime/OwnPtr.h>
+#include <libruntime/RefCounted.h>
+#include <libruntime/RefPtr.h>
+
+using namespace libruntime;
+
+static int object_instance_count = 0;
+
+class Object : public ArenaAllocated
+{
+private:
+    int _x;
+
+public:
+    int x() { return _x; }
+    Object(int x) : _x(x) { object_instance_count++; }
+    ~Object() { object_instance_count--; }
+};
+
+class SharedObject :
+    public RefCounted<SharedObject>,
+    public ArenaAllocated
+{
+public:
+    SharedObject() { object_instance_count++; }
+    ~SharedObject() { object_instance_count--; }
+};
+
+void test_bump_allocation()
+{
+    Arena arena(256);
+
+    void *a = arena.alloc(1);
+    void *b = arena.alloc(1);
+
+    // Every allocation is aligned and follows the previous one
+    assert((uintptr_t)a % ARENA_ALIGNMENT == 0);
+    assert((uintptr_t)b % ARENA_ALIGNMENT == 0);
+    assert((byte *)b == (byte *)a + ARENA_ALIGNMENT);
+    assert(arena.used() == ARENA_ALIGNMENT + 1);
+
+    // Resetting give everything back
+    arena.reset();
+    assert(arena.used() == 0);
+    assert(arena.alloc(1) == a);
+}
+
+void test_scoped_reset()
+{
+    Arena arena(256);
+
+    void *outer = arena.alloc(32);
+    size_t used = arena.used();
+
+    {
+        Arena::Scope scope(arena);
+
+        arena.alloc(64);
+        assert(arena.used() > used);
+
+        {
+            Arena::Scope inner_scope(arena);
+            arena.alloc(64);
+        }
+
+        assert(arena.used() == used + 64);
+    }
+
+    // Only what was allocated in the scope is released
+    assert(arena.used() == used);
+    assert(arena.alloc(1) != outer);
+}
+
+void test_smart_pointers()
+{
+    Arena arena(256);
+
+    {
+        // Deleting runs the destructor but leave the memory to the arena
+        OwnPtr<Object> object(new (arena) Object(10));
+        assert(object_instance_count == 1);
+        assert(object->x() == 10);
+    }
+
+    assert(object_instance_count == 0);
+    size_t used = arena.used();
+
+    {
+        RefPtr<SharedObject> a = adopt(*new (arena) SharedObject());
+        RefPtr<SharedObject> b = a;
+        assert(a.refcount() == 2);
+        assert(object_instance_count == 1);
+    }
+
+    assert(object_instance_count == 0);
+    assert(arena.used() > used);
+}
+
+int main(int argc, char const *argv[])
+{
+    __unused(argc);
+    __unused(argv);
+
+    test_bump_allocation();
+    test_scoped_reset();
+    test_smart_pointers();
+
+    assert(object_instance_count == 0);
+
+    return 0;
+}
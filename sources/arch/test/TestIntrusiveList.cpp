@@ -0,0 +1,72 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <assert.h>
+#include <libruntime/IntrusiveList.h>
+#include <libruntime/Macros.h>
+
+struct Item
+{
+    int value;
+    libruntime::IntrusiveListNode node;
+    libruntime::IntrusiveListNode other_node;
+};
+
+typedef libruntime::IntrusiveList<Item, &Item::node> List;
+typedef libruntime::IntrusiveList<Item, &Item::other_node> OtherList;
+
+int main(int argc, char const *argv[])
+{
+    __unused(argc);
+    __unused(argv);
+
+    // Empty list
+
+    List list{};
+
+    assert(!list.any());
+    assert(list.empty());
+    assert(list.count() == 0);
+    assert(list.pop() == nullptr);
+
+    // List with elements
+    Item items[5] = {{1, {}, {}}, {2, {}, {}}, {3, {}, {}}, {4, {}, {}}, {5, {}, {}}};
+
+    for (auto &item : items)
+    {
+        list.push_back(item);
+    }
+
+    assert(list.count() == 5);
+    assert(list.first() == &items[0]);
+    assert(list.last() == &items[4]);
+    assert(List::is_linked(items[2]));
+
+    // Unlinking from the middle, the head and the tail
+    list.remove(items[2]);
+    list.remove(items[0]);
+    list.remove(items[4]);
+
+    assert(!List::is_linked(items[2]));
+    assert(list.count() == 2);
+    assert(list.first() == &items[1]);
+    assert(list.next(items[1]) == &items[3]);
+    assert(list.next(items[3]) == nullptr);
+
+    // An item can be in as many lists as it has nodes
+    OtherList other{};
+    other.push(items[1]);
+    other.push(items[3]);
+    assert(other.first() == &items[3]);
+
+    assert(list.take_if([](Item &item) { return item.value == 4; }) == &items[3]);
+    assert(list.take_if([](Item &item) { return item.value == 4; }) == nullptr);
+    assert(OtherList::is_linked(items[3]));
+
+    assert(list.pop() == &items[1]);
+    assert(list.empty());
+    assert(other.count() == 2);
+
+    return 0;
+}
@@ -2,13 +2,18 @@
 /* This code is licensed under the 3-Clause BSD License.                      */
 /* See: LICENSE.md                                                            */
 
+// Build from the root of the repository with:
+//   g++ -std=c++17 -O2 -I. -Isources -Isources/libraries sources/arch/test/TestRefPtr.cpp sources/arch/test/__plugs__.cpp
+
 #include <assert.h>
 #include <stdio.h>
 
+#include <libruntime/LinkedList.h>
 #include <libruntime/Macros.h>
 #include <libruntime/Move.h>
 #include <libruntime/RefCounted.h>
 #include <libruntime/RefPtr.h>
+#include <libruntime/WeakPtr.h>
 
 using namespace libruntime;
 
@@ -53,6 +58,60 @@ void test_coping_ref()
     assert(object_instance_count == 1);
 }
 
+void test_weak_ref()
+{
+    RefPtr<Object> a = make<Object>(10);
+
+    // Weak references don't keep the object alive
+    WeakPtr<Object> weak = a;
+    WeakPtr<Object> other_weak = weak;
+    assert(a.refcount() == 1);
+    assert(weak == other_weak);
+
+    // But give a strong one while it is
+    RefPtr<Object> b = weak.strong();
+    assert(b == a);
+    assert(a.refcount() == 2);
+
+    a = nullptr;
+    assert(b.refcount() == 1);
+    assert(object_instance_count == 1);
+
+    b = nullptr;
+    assert(object_instance_count == 0);
+
+    // And nothing once it's gone
+    assert(!weak.strong());
+    assert(!other_weak.strong());
+}
+
+void test_borrowing_ref()
+{
+    RefPtr<Object> a = make<Object>(10);
+
+    // Views don't take references
+    RefPtrView<Object> view = a;
+    assert(a.refcount() == 1);
+    assert(view == a.necked());
+    assert(view->x() == 10);
+
+    // Unless they are kept
+    RefPtr<Object> b = view;
+    assert(a.refcount() == 2);
+    b = nullptr;
+
+    // Moving in and out of a list doesn't touch the refcount either
+    Object *object = a.necked();
+    LinkedList<RefPtr<Object>> list;
+    list.push_back(libruntime::move(a));
+    assert(!a);
+    assert(object->refcount() == 1);
+
+    RefPtr<Object> c = list.take_if([](auto &object) { return object->x() == 10; });
+    assert(c.refcount() == 1);
+    assert(list.empty());
+}
+
 int main(int argc, char const *argv[])
 {
     __unused(argc);
@@ -61,6 +120,10 @@ int main(int argc, char const *argv[])
     assert(object_instance_count == 0);
     test_coping_ref();
     assert(object_instance_count == 0);
+    test_weak_ref();
+    assert(object_instance_count == 0);
+    test_borrowing_ref();
+    assert(object_instance_count == 0);
 
     return 0;
 }
@@ -0,0 +1,333 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+// Turn the trace records found in a serial log of a kernel built with
+// BUILD_TRACE=yes into the JSON of the Chrome trace event format, to be opened
+// in chrome://tracing or https://ui.perfetto.dev.
+//
+// Each cpu is a track: the thread running on it is a slice from the switch to
+// it to the switch away, interrupts are slices nested in it and everything
+// else is an instant event. Lines which aren't trace records are skipped.
+//
+// Build from the root of the repository with:
+//   g++ -std=c++17 -O2 -I. -Isources -Isources/libraries sources/arch/test/TraceDecoder.cpp
+//
+// Then run it with:
+//   ./a.out serial.log > trace.json
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "system/trace/TraceRecord.h"
+
+using namespace system::trace;
+
+#define DECODER_MAX_CPU_COUNT 64
+#define DECODER_LINE_SIZE 4096
+
+#define TRACE_EVENT_NAME_ENTRY(__x) #__x,
+
+static const char *_event_names[] = {TRACE_EVENT_LIST(TRACE_EVENT_NAME_ENTRY)};
+
+// Same order as THREAD_STATE_LIST and BLOCKER_TYPE_LIST in the kernel.
+static const char *_thread_states[] = {"EMBRYO", "RUNNING", "READY", "BLOCKED", "STOPPED"};
+static const char *_blocker_types[] = {"SLEEP", "MUTEX", "WAIT", "JOIN"};
+
+#define ARRAY_LENGTH(__array) (sizeof(__array) / sizeof(__array[0]))
+
+static const char *name_of(const char *names[], size_t count, uint32_t index)
+{
+    return index < count ? names[index] : "UNKNOWN";
+}
+
+struct DecoderCpu
+{
+    bool seen;
+    bool running; // A thread slice is open.
+    size_t interrupts; // Interrupt slices open in it.
+    double last;
+};
+
+static DecoderCpu _cpus[DECODER_MAX_CPU_COUNT];
+
+// Drained from the rings of every cpu in turn, so the records must all be
+// read before the earliest one is known.
+struct DecoderEntry
+{
+    size_t cpu;
+    bool dropped;
+    unsigned dropped_count;
+    TraceRecord record;
+};
+
+static std::vector<DecoderEntry> _entries;
+
+static double _cycles_per_microsecond = 1;
+static uint64_t _origin = UINT64_MAX;
+static bool _first_event = true;
+
+static void begin_event(const char *phase, size_t cpu, double timestamp)
+{
+    printf("%s\n    {\"ph\": \"%s\", \"pid\": 0, \"tid\": %zu, \"ts\": %.3f",
+           _first_event ? "" : ",", phase, cpu, timestamp);
+
+    _first_event = false;
+}
+
+static void slice_begin(size_t cpu, double timestamp, const char *name, const char *category)
+{
+    begin_event("B", cpu, timestamp);
+    printf(", \"name\": \"%s\", \"cat\": \"%s\"}", name, category);
+}
+
+static void slice_end(size_t cpu, double timestamp)
+{
+    begin_event("E", cpu, timestamp);
+    printf("}");
+}
+
+static void close_interrupts(size_t cpu, double timestamp)
+{
+    for (; _cpus[cpu].interrupts > 0; _cpus[cpu].interrupts--)
+    {
+        slice_end(cpu, timestamp);
+    }
+}
+
+static void close_all(size_t cpu, double timestamp)
+{
+    close_interrupts(cpu, timestamp);
+
+    if (_cpus[cpu].running)
+    {
+        slice_end(cpu, timestamp);
+        _cpus[cpu].running = false;
+    }
+}
+
+static void decode_record(size_t cpu, TraceRecord &record)
+{
+    // The clocks of the cpus may differ a little, don't let time go backward.
+    double timestamp = (record.timestamp - _origin) / _cycles_per_microsecond;
+
+    if (timestamp < _cpus[cpu].last)
+    {
+        timestamp = _cpus[cpu].last;
+    }
+
+    _cpus[cpu].last = timestamp;
+    _cpus[cpu].seen = true;
+
+    uint32_t args[3];
+    memcpy(args, record.args, sizeof(args));
+    char name[64];
+
+    switch (record.event)
+    {
+    case TraceEvent::SWITCH:
+        // The interrupt which preempted the thread ended before the switch.
+        close_all(cpu, timestamp);
+
+        snprintf(name, sizeof(name), "thread %u", args[1]);
+        begin_event("B", cpu, timestamp);
+        printf(", \"name\": \"%s\", \"cat\": \"thread\", \"args\": {\"from\": %u, \"from_state\": \"%s\"}}",
+               name, args[0], name_of(_thread_states, ARRAY_LENGTH(_thread_states), args[2]));
+
+        _cpus[cpu].running = true;
+        break;
+
+    case TraceEvent::IRQ_ENTER:
+        snprintf(name, sizeof(name), "irq %u", args[0]);
+        slice_begin(cpu, timestamp, name, "interrupt");
+
+        _cpus[cpu].interrupts++;
+        break;
+
+    case TraceEvent::IRQ_EXIT:
+        // The ring may have started to be drained in the middle of one.
+        if (_cpus[cpu].interrupts > 0)
+        {
+            slice_end(cpu, timestamp);
+            _cpus[cpu].interrupts--;
+        }
+        break;
+
+    default:
+        begin_event("i", cpu, timestamp);
+        printf(", \"s\": \"t\", \"name\": \"%s\", \"cat\": \"event\", \"args\": {",
+               name_of(_event_names, ARRAY_LENGTH(_event_names), static_cast<uint32_t>(record.event)));
+
+        if (record.event == TraceEvent::BLOCK)
+        {
+            printf("\"thread\": %u, \"blocker\": \"%s\"", args[0], name_of(_blocker_types, ARRAY_LENGTH(_blocker_types), args[1]));
+        }
+        else if (record.event == TraceEvent::WAKEUP)
+        {
+            printf("\"thread\": %u, \"cpu\": %u", args[0], args[1]);
+        }
+        else if (record.event == TraceEvent::PAGE_ALLOC || record.event == TraceEvent::PAGE_FREE)
+        {
+            printf("\"base\": \"0x%08x\", \"pages\": %u", args[0], args[1]);
+        }
+        else
+        {
+            printf("\"thread\": %u", args[0]);
+        }
+
+        printf("}}");
+        break;
+    }
+}
+
+static void decode_dropped(size_t cpu, unsigned dropped)
+{
+    double timestamp = _cpus[cpu].last;
+
+    // Whatever was open may have ended in the records which are lost.
+    close_all(cpu, timestamp);
+
+    begin_event("i", cpu, timestamp);
+    printf(", \"s\": \"t\", \"name\": \"DROPPED\", \"cat\": \"event\", \"args\": {\"records\": %u}}", dropped);
+}
+
+static int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+
+    return -1;
+}
+
+static bool parse_record(const char *hex, TraceRecord &record)
+{
+    auto *bytes = reinterpret_cast<uint8_t *>(&record);
+
+    for (size_t i = 0; i < sizeof(TraceRecord); i++)
+    {
+        int high = hex_digit(hex[i * 2]);
+        int low = hex_digit(hex[i * 2 + 1]);
+
+        if (high < 0 || low < 0)
+        {
+            return false;
+        }
+
+        bytes[i] = high << 4 | low;
+    }
+
+    return static_cast<uint32_t>(record.event) < static_cast<uint32_t>(TraceEvent::__COUNT);
+}
+
+static void parse_line(const char *line)
+{
+    // Something else may have been written on the same line before.
+    const char *start = strstr(line, TRACE_LINE_RECORD);
+
+    if (start == nullptr)
+    {
+        return;
+    }
+
+    size_t cpu;
+    unsigned value;
+    char hex[2 * sizeof(TraceRecord) + 1];
+
+    if (sscanf(start, TRACE_LINE_CLOCK " %u", &value) == 1)
+    {
+        if (value > 0)
+        {
+            _cycles_per_microsecond = value / 1000.0;
+        }
+    }
+    else if (sscanf(start, TRACE_LINE_DROPPED " %zu %u", &cpu, &value) == 2)
+    {
+        if (cpu < DECODER_MAX_CPU_COUNT)
+        {
+            _entries.push_back({cpu, true, value, {}});
+        }
+    }
+    else if (sscanf(start, TRACE_LINE_RECORD " %zu %48[0-9a-f]", &cpu, hex) == 2)
+    {
+        TraceRecord record;
+
+        if (cpu < DECODER_MAX_CPU_COUNT && strlen(hex) == sizeof(hex) - 1 && parse_record(hex, record))
+        {
+            _entries.push_back({cpu, false, 0, record});
+
+            if (record.timestamp < _origin)
+            {
+                _origin = record.timestamp;
+            }
+        }
+    }
+}
+
+int main(int argc, char const *argv[])
+{
+    FILE *input = stdin;
+
+    if (argc > 1)
+    {
+        input = fopen(argv[1], "r");
+
+        if (input == nullptr)
+        {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    printf("{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+
+    static char line[DECODER_LINE_SIZE];
+
+    while (fgets(line, sizeof(line), input))
+    {
+        parse_line(line);
+    }
+
+    for (auto &entry : _entries)
+    {
+        if (entry.dropped)
+        {
+            decode_dropped(entry.cpu, entry.dropped_count);
+        }
+        else
+        {
+            decode_record(entry.cpu, entry.record);
+        }
+    }
+
+    for (size_t cpu = 0; cpu < DECODER_MAX_CPU_COUNT; cpu++)
+    {
+        if (!_cpus[cpu].seen)
+        {
+            continue;
+        }
+
+        close_all(cpu, _cpus[cpu].last);
+
+        begin_event("M", cpu, 0);
+        printf(", \"name\": \"thread_name\", \"args\": {\"name\": \"cpu %zu\"}}", cpu);
+    }
+
+    printf("\n]}\n");
+
+    if (input != stdin)
+    {
+        fclose(input);
+    }
+
+    return 0;
+}
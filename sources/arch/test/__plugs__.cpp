@@ -4,6 +4,7 @@
 
 #include <libsystem/__plugs__.h>
 
+#include <assert.h>
 #include <fcntl.h>
 #include <stdlib.h>
 #include <string.h>
@@ -71,4 +72,52 @@ libruntime::ErrorOr<size_t> file_tell(int handle)
     return file_seek(handle, 0, libsystem::CURRENT);
 }
 
+bool interrupts_disable()
+{
+    return false;
+}
+
+void interrupts_restore(bool were_enabled)
+{
+    __unused(were_enabled);
+}
+
+// Same as MAX_CPU_COUNT, system/System.h can't be included next to the libc,
+// its namespace would clash with system().
+#define PLUGS_CPU_COUNT 8
+
+// Threads get their own caches, like cpus do in the kernel. Each one takes a
+// free slot the first time it asks, and gives it back when it exits, so no
+// more than PLUGS_CPU_COUNT of them may be running at once.
+static bool _cpu_slots[PLUGS_CPU_COUNT];
+
+struct HostCpu
+{
+    size_t index;
+
+    HostCpu()
+    {
+        index = 0;
+
+        while (index < PLUGS_CPU_COUNT && __atomic_exchange_n(&_cpu_slots[index], true, __ATOMIC_ACQUIRE))
+        {
+            index++;
+        }
+
+        assert(index < PLUGS_CPU_COUNT);
+    }
+
+    ~HostCpu()
+    {
+        __atomic_store_n(&_cpu_slots[index], false, __ATOMIC_RELEASE);
+    }
+};
+
+static thread_local HostCpu _host_cpu;
+
+size_t current_cpu()
+{
+    return _host_cpu.index;
+}
+
 } // namespace __plugs__
\ No newline at end of file
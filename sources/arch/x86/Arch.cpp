@@ -4,6 +4,12 @@
 
 #include <arch/Arch.h>
 
+#include "arch/x86/device/ClockEvent.h"
+#include "arch/x86/memory/AddressSpace.h"
+#include "arch/x86/paging/Paging.h"
+#include "arch/x86/paging/TLB.h"
+#include "arch/x86/smp/SMP.h"
+#include "arch/x86/tasking/FPU.h"
 #include "arch/x86/tasking/x86Thread.h"
 #include "arch/x86/x86.h"
 
@@ -37,9 +43,63 @@ void halt()
     x86::hlt();
 }
 
-void yield()
+void switch_context(system::tasking::Thread &from, system::tasking::Thread &to)
 {
-    x86::raise_irq1();
+    x86::fpu_switch_out(static_cast<x86::x86Thread &>(from));
+
+    x86::switch_stack(from.stack().get_pointer_address(), to.stack().get_pointer());
+}
+
+bool disable_interrupts()
+{
+    bool were_enabled = x86::eflags() & EFLAGS_IF;
+
+    x86::cli();
+
+    return were_enabled;
+}
+
+void restore_interrupts(bool were_enabled)
+{
+    if (were_enabled)
+    {
+        x86::sti();
+    }
+}
+
+int get_current_cpu()
+{
+    return x86::smp_current_cpu();
+}
+
+void kick_cpu(int cpu)
+{
+    x86::smp_kick(cpu);
+}
+
+uint64_t clock_ticks()
+{
+    return x86::clock_ticks();
+}
+
+uint64_t clock_cycles()
+{
+    return x86::clock_cycles();
+}
+
+uint32_t clock_cycles_per_tick()
+{
+    return x86::clock_cycles_per_tick();
+}
+
+void stop_tick(uint64_t until)
+{
+    x86::clock_stop_tick(until);
+}
+
+void start_tick()
+{
+    x86::clock_start_tick();
 }
 
 size_t get_page_size()
@@ -55,9 +115,45 @@ system::memory::MemoryRegion get_kernel_region()
     return MemoryRegion::create_around_non_aligned_address(addr, size);
 }
 
+system::memory::MemoryRegion get_reserved_low_region()
+{
+    // Real mode memory: the IVT, the BIOS data area and the smp trampoline.
+    return MemoryRegion::from_aligned_address(0, 0x100000);
+}
+
+system::memory::MemoryRegion get_direct_map_region()
+{
+    return MemoryRegion::from_aligned_address(0, USER_HALF_BASE);
+}
+
+system::memory::MemoryRegion get_kernel_stack_region()
+{
+    return MemoryRegion::from_aligned_address(KERNEL_STACK_BASE, KERNEL_STACK_END - KERNEL_STACK_BASE);
+}
+
+void map_kernel_stack_page(uintptr_t virtual_address, uintptr_t physical_address)
+{
+    x86::paging_map_kernel_stack(virtual_address, physical_address);
+}
+
+void free_unmapped_region(system::memory::MemoryRegion region)
+{
+    x86::tlb_free_after_shootdown(region);
+}
+
+void wait_unmapped_regions()
+{
+    x86::tlb_shootdown_wait();
+}
+
 libruntime::RefPtr<system::tasking::Thread> create_thread(libruntime::RefPtr<system::tasking::Process> process, system::tasking::ThreadEntry entry)
 {
     return libruntime::make<x86::x86Thread>(process, entry);
 }
 
+libruntime::OwnPtr<system::memory::AddressSpace> create_address_space()
+{
+    return libruntime::own<x86::AddressSpace>();
+}
+
 } // namespace arch
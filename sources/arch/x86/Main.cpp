@@ -10,14 +10,21 @@
 #include "arch/x86/device/CGATerminal.h"
 #include "arch/x86/device/SerialStream.h"
 #include "arch/x86/interupts/Interupts.h"
+#include "arch/x86/paging/Paging.h"
 #include "arch/x86/segmentation/Segmentation.h"
+#include "arch/x86/smp/SMP.h"
+#include "arch/x86/tasking/FPU.h"
 
 #include "system/System.h"
 #include "system/acpi/ACPI.h"
 #include "system/memory/Memory.h"
+#include "system/scheduling/Condition.h"
+#include "system/scheduling/Mutex.h"
 #include "system/scheduling/Scheduling.h"
+#include "system/scheduling/WaitQueue.h"
 #include "system/tasking/Process.h"
 #include "system/tasking/Tasking.h"
+#include "system/trace/Trace.h"
 
 using namespace system;
 using namespace libruntime;
@@ -50,6 +57,226 @@ void taskB()
     tasking::Thread::exit();
 }
 
+#ifdef __CONFIG_BENCH_YIELD__
+
+#define BENCH_YIELD_DURATION 1000
+
+static volatile bool _bench_yield_stop;
+static volatile size_t _bench_yield_count;
+
+void bench_yield_task()
+{
+    while (!_bench_yield_stop)
+    {
+        _bench_yield_count++;
+        scheduling::yield();
+    }
+
+    tasking::Thread::exit();
+}
+
+// Run before the other cpus are up, so the two threads can only pass the
+// boot processor to each other while the main thread sleeps.
+void bench_yield()
+{
+    auto ping = tasking::Thread::create(tasking::kernel_process(), bench_yield_task).value();
+    auto pong = tasking::Thread::create(tasking::kernel_process(), bench_yield_task).value();
+
+    uint64_t start = arch::clock_ticks();
+
+    ping->start();
+    pong->start();
+
+    tasking::Thread::sleep(BENCH_YIELD_DURATION);
+    _bench_yield_stop = true;
+
+    tasking::Thread::join(ping);
+    tasking::Thread::join(pong);
+
+    size_t elapsed = arch::clock_ticks() - start;
+
+    logger_info("Yield ping-pong: {} yields in {}ms", (size_t)_bench_yield_count, elapsed);
+}
+
+#endif
+
+#ifdef __CONFIG_TEST_SCHEDULING__
+
+#define TEST_THREAD_COUNT 3
+
+// Long enough for a thread which was started or woken up to run until it waits again.
+#define TEST_SETTLE 10
+
+struct TestState
+{
+    scheduling::Mutex mutex;
+    scheduling::Condition condition;
+
+    size_t started;
+    size_t tickets;
+    bool finish;
+
+    size_t woken;
+    size_t order[TEST_THREAD_COUNT];
+    size_t finished;
+};
+
+static TestState *_test;
+
+// Started one by one, and each given the time to wait before the next, so
+// they wait in the order of their index.
+static void test_start_threads(RefPtr<tasking::Thread> *threads, tasking::ThreadEntry entry)
+{
+    for (size_t i = 0; i < TEST_THREAD_COUNT; i++)
+    {
+        threads[i] = tasking::Thread::create(tasking::kernel_process(), entry).value();
+        threads[i]->start();
+
+        tasking::Thread::sleep(TEST_SETTLE);
+    }
+}
+
+static void test_join_threads(RefPtr<tasking::Thread> *threads)
+{
+    for (size_t i = 0; i < TEST_THREAD_COUNT; i++)
+    {
+        tasking::Thread::join(threads[i]);
+    }
+}
+
+void test_mutex_task()
+{
+    size_t index = _test->started++;
+
+    _test->mutex.acquire();
+    _test->order[_test->woken++] = index;
+    _test->mutex.release();
+
+    tasking::Thread::exit();
+}
+
+// The mutex is handed to the oldest waiter, and stays locked in between.
+void test_mutex()
+{
+    TestState state = {};
+    _test = &state;
+
+    RefPtr<tasking::Thread> threads[TEST_THREAD_COUNT];
+
+    state.mutex.acquire();
+
+    test_start_threads(threads, test_mutex_task);
+
+    assert(state.woken == 0);
+
+    state.mutex.release();
+
+    // Handed over, so it can't be taken until every waiter had it.
+    bool acquired = state.mutex.try_acquire();
+    assert(!acquired || state.woken == TEST_THREAD_COUNT);
+
+    if (acquired)
+    {
+        state.mutex.release();
+    }
+
+    test_join_threads(threads);
+
+    for (size_t i = 0; i < TEST_THREAD_COUNT; i++)
+    {
+        assert(state.order[i] == i);
+    }
+
+    acquired = state.mutex.try_acquire();
+    assert(acquired);
+    state.mutex.release();
+}
+
+void test_condition_task()
+{
+    _test->mutex.acquire();
+
+    size_t index = _test->started++;
+
+    while (_test->tickets == 0)
+    {
+        _test->condition.wait(_test->mutex);
+    }
+
+    _test->tickets--;
+    _test->order[_test->woken++] = index;
+
+    while (!_test->finish)
+    {
+        _test->condition.wait(_test->mutex);
+    }
+
+    _test->finished++;
+    _test->mutex.release();
+
+    tasking::Thread::exit();
+}
+
+// signal() wakes up the oldest waiter, a woken thread waits again at the
+// back, broadcast() wakes up all of them.
+void test_condition()
+{
+    TestState state = {};
+    _test = &state;
+
+    RefPtr<tasking::Thread> threads[TEST_THREAD_COUNT];
+
+    test_start_threads(threads, test_condition_task);
+
+    assert(state.woken == 0);
+
+    for (size_t i = 0; i < TEST_THREAD_COUNT; i++)
+    {
+        state.mutex.acquire();
+        state.tickets++;
+        state.condition.signal();
+        state.mutex.release();
+
+        tasking::Thread::sleep(TEST_SETTLE);
+
+        assert(state.woken == i + 1);
+        assert(state.order[i] == i);
+    }
+
+    state.mutex.acquire();
+    state.finish = true;
+    state.condition.broadcast();
+    state.mutex.release();
+
+    test_join_threads(threads);
+
+    assert(state.finished == TEST_THREAD_COUNT);
+}
+
+void test_wait_queue()
+{
+    scheduling::WaitQueue queue;
+
+    // Nothing to wait for once the condition is true.
+    queue.wait_until([]() { return true; });
+
+    bool was_waiting = queue.wake_one();
+    assert(!was_waiting);
+}
+
+// Run before the other cpus are up, so the threads run in the order they
+// are woken up, and a mutex owner never runs while we spin on it.
+void test_scheduling()
+{
+    test_mutex();
+    test_condition();
+    test_wait_queue();
+
+    logger_info("Scheduling tests passed");
+}
+
+#endif
+
 extern "C" void arch_main(uint32_t multiboot_magic, uintptr_t multiboot_addr)
 {
     auto serial = SerialStream(SerialPort::COM1);
@@ -84,7 +311,7 @@ extern "C" void arch_main(uint32_t multiboot_magic, uintptr_t multiboot_addr)
         if (entry.is_available())
         {
             logger_info("Marking {} as free usable memory by the kernel...", entry);
-            memory::free_region(entry.region());
+            memory::add_region(entry.region());
         }
         else if (entry.is_bad())
         {
@@ -103,8 +330,12 @@ extern "C" void arch_main(uint32_t multiboot_magic, uintptr_t multiboot_addr)
         PANIC("Failled to bootstrap the memory manager!");
     }
 
+    logger_info("{}KiB of memory used, {}KiB free, {}KiB total.", memory::used() / 1024, memory::free() / 1024, memory::total() / 1024);
+
     x86::segmentation_initialize();
+    x86::paging_initialize();
     x86::interupts_initialise();
+    x86::fpu_initialize();
 
     libsystem::stdout = make<x86::CGATerminal>(reinterpret_cast<void *>(0xB8000));
 
@@ -119,9 +350,21 @@ extern "C" void arch_main(uint32_t multiboot_magic, uintptr_t multiboot_addr)
         acpi::initialize(rsdp);
     }
 
-    auto task_a = tasking::Thread::create(tasking::kernel_process(), reinterpret_cast<tasking::ThreadEntry>(taskA));
+#ifdef __CONFIG_BENCH_YIELD__
+    bench_yield();
+#endif
+
+#ifdef __CONFIG_TEST_SCHEDULING__
+    test_scheduling();
+#endif
+
+    x86::smp_initialize();
+
+    trace::initialize();
+
+    auto task_a = tasking::Thread::create(tasking::kernel_process(), reinterpret_cast<tasking::ThreadEntry>(taskA)).value();
     task_a->start();
-    tasking::Thread::create(tasking::kernel_process(), reinterpret_cast<tasking::ThreadEntry>(taskB))->start();
+    tasking::Thread::create(tasking::kernel_process(), reinterpret_cast<tasking::ThreadEntry>(taskB)).value()->start();
 
     print(" ☺ hjert kernel ({} {})\n", __BUILD_TARGET__, __BUILD_GITREF__);
     print("════════════════════════════════════════════════════════════════════════════════\n");
@@ -130,6 +373,9 @@ extern "C" void arch_main(uint32_t multiboot_magic, uintptr_t multiboot_addr)
 
     tasking::Thread::join(task_a);
 
+    scheduling::dump_statistics();
+    tasking::dump_threads();
+
     do
     {
         stderr->write("K", 1);
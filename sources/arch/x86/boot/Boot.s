@@ -50,6 +50,19 @@ _start:
     cld
 
     mov esp, stack_top
+
+    ; Enable the FPU and SSE, the kernel itself never uses them. Threads
+    ; get their own state the first time they do, see FPU.cpp.
+    mov eax, cr0
+    and eax, ~(1 << 2)          ; CR0.EM
+    or eax, (1 << 1) | (1 << 5) ; CR0.MP and CR0.NE
+    mov cr0, eax
+
+    mov eax, cr4
+    or eax, (1 << 9) | (1 << 10) ; CR4.OSFXSR and CR4.OSXMMEXCPT
+    mov cr4, eax
+
+    fninit
     push 0
     push 0
     mov ebp, esp
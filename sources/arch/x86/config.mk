@@ -1,4 +1,4 @@
-KCXXFLAGS+=-mno-80387 \
+KERNEL_CXXFLAGS+=-mno-80387 \
 		   -mno-mmx \
 		   -mno-sse \
 		   -mno-sse2
@@ -0,0 +1,234 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libmath/MinMax.h>
+#include <libruntime/Macros.h>
+#include <libsystem/Logger.h>
+
+#include "arch/Arch.h"
+#include "arch/x86/device/ClockEvent.h"
+#include "arch/x86/device/PIT.h"
+#include "arch/x86/device/TSC.h"
+#include "arch/x86/interupts/LAPIC.h"
+#include "arch/x86/interupts/Pic.h"
+#include "arch/x86/x86.h"
+#include "system/System.h"
+#include "system/scheduling/Scheduling.h"
+
+namespace x86
+{
+
+#define PIT_IRQ 0
+
+class PITClockEvent : public ClockEvent
+{
+public:
+    const char *name() { return "PIT"; }
+
+    bool can_oneshot() { return false; }
+
+    void start_periodic()
+    {
+        pit_start_periodic(TICK_FREQUENCY);
+        pic_unmask(PIT_IRQ);
+    }
+
+    void start_oneshot(uint64_t tick) { __unused(tick); }
+};
+
+class LAPICClockEvent : public ClockEvent
+{
+public:
+    const char *name() { return "LAPIC"; }
+
+    bool can_oneshot() { return true; }
+
+    void start_periodic() { lapic_timer_periodic(TICK_FREQUENCY); }
+
+    void start_oneshot(uint64_t tick)
+    {
+        uint64_t now = clock_ticks();
+        uint32_t ticks = tick > now ? tick - now : 1;
+
+        lapic_timer_oneshot(ticks * (1000 / TICK_FREQUENCY));
+    }
+};
+
+// The TSC deadline mode only knows about one-shots, the periodic tick is
+// made by arming the next one from the interrupt.
+class TSCDeadlineClockEvent : public ClockEvent
+{
+private:
+    bool _periodic = false;
+
+    void arm_next_tick()
+    {
+        lapic_timer_deadline(tsc_at_tick(clock_ticks() + 1));
+    }
+
+public:
+    const char *name() { return "TSC-deadline"; }
+
+    bool can_oneshot() { return true; }
+
+    void start_periodic()
+    {
+        _periodic = true;
+        arm_next_tick();
+    }
+
+    void start_oneshot(uint64_t tick)
+    {
+        _periodic = false;
+        lapic_timer_deadline(tsc_at_tick(libmath::max(tick, clock_ticks() + 1)));
+    }
+
+    void handle()
+    {
+        if (_periodic)
+        {
+            arm_next_tick();
+        }
+    }
+};
+
+static ClockEvent *_events[MAX_CPU_COUNT] = {};
+static bool _tick_stopped[MAX_CPU_COUNT] = {};
+
+// Counted by the boot processor until the TSC takes over.
+static uint64_t _counted_ticks = 0;
+static bool _tsc_clock = false;
+
+// The TSC counts cycles from the start, even before it's calibrated.
+static bool _tsc_cycles = false;
+
+static ClockEvent *best_clock_event()
+{
+    if (!lapic_is_available())
+    {
+        return new PITClockEvent();
+    }
+
+    if (_tsc_clock && tsc_has_deadline())
+    {
+        return new TSCDeadlineClockEvent();
+    }
+
+    return new LAPICClockEvent();
+}
+
+void clock_initialize_cpu()
+{
+    int cpu = arch::get_current_cpu();
+
+    if (cpu == 0)
+    {
+        _tsc_cycles = tsc_is_available();
+    }
+
+    _events[cpu] = best_clock_event();
+    _events[cpu]->start_periodic();
+
+    logger_info("Cpu {} ticks with the {}", cpu, _events[cpu]->name());
+}
+
+void clock_initialize()
+{
+    bool were_enabled = arch::disable_interrupts();
+
+    if (tsc_is_available())
+    {
+        // The TSC starts counting from where the boot processor left off.
+        tsc_calibrate(__atomic_load_n(&_counted_ticks, __ATOMIC_SEQ_CST));
+        _tsc_clock = true;
+    }
+
+    if (lapic_is_available())
+    {
+        pic_mask(PIT_IRQ);
+
+        delete _events[arch::get_current_cpu()];
+        clock_initialize_cpu();
+    }
+
+    arch::restore_interrupts(were_enabled);
+}
+
+uint64_t clock_ticks()
+{
+    if (_tsc_clock)
+    {
+        return tsc_ticks();
+    }
+
+    return __atomic_load_n(&_counted_ticks, __ATOMIC_SEQ_CST);
+}
+
+uint64_t clock_cycles()
+{
+    if (_tsc_cycles)
+    {
+        return rdtsc();
+    }
+
+    return clock_ticks();
+}
+
+uint32_t clock_cycles_per_tick()
+{
+    if (_tsc_cycles)
+    {
+        return tsc_cycles_per_tick();
+    }
+
+    return 1;
+}
+
+bool clock_handle()
+{
+    int cpu = arch::get_current_cpu();
+
+    if (_events[cpu])
+    {
+        _events[cpu]->handle();
+    }
+
+    if (!_tsc_clock && cpu == 0)
+    {
+        __atomic_add_fetch(&_counted_ticks, 1, __ATOMIC_SEQ_CST);
+    }
+
+    system::tick();
+
+    return system::scheduling::tick();
+}
+
+void clock_stop_tick(uint64_t until)
+{
+    int cpu = arch::get_current_cpu();
+
+    // Without the TSC, time only moves forward with the tick of the boot processor.
+    if (!_tsc_clock || !_events[cpu] || !_events[cpu]->can_oneshot())
+    {
+        return;
+    }
+
+    _events[cpu]->start_oneshot(until);
+    _tick_stopped[cpu] = true;
+}
+
+void clock_start_tick()
+{
+    int cpu = arch::get_current_cpu();
+
+    if (!_tick_stopped[cpu])
+    {
+        return;
+    }
+
+    _events[cpu]->start_periodic();
+    _tick_stopped[cpu] = false;
+}
+
+} // namespace x86
@@ -0,0 +1,56 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Types.h>
+
+namespace x86
+{
+
+// Something which interrupts the current cpu at the start of every tick, or
+// only once at the start of a given tick, to let it sleep while idle.
+class ClockEvent
+{
+public:
+    ClockEvent() {}
+    virtual ~ClockEvent() {}
+
+    virtual const char *name() = 0;
+
+    virtual bool can_oneshot() = 0;
+
+    virtual void start_periodic() = 0;
+
+    virtual void start_oneshot(uint64_t tick) = 0;
+
+    // Called on each interrupt, before the kernel look at the time.
+    virtual void handle() {}
+};
+
+// Start the tick of the current cpu with the best clock event it has.
+void clock_initialize_cpu();
+
+// Once the local APIC timer is calibrated, use the TSC as clock source and
+// move the boot processor away from the PIT.
+void clock_initialize();
+
+// Ticks elapsed since boot.
+uint64_t clock_ticks();
+
+// The TSC if the cpu has one, or else the ticks.
+uint64_t clock_cycles();
+
+uint32_t clock_cycles_per_tick();
+
+// Must be called by the interrupt of the clock event of the current cpu,
+// return true if the scheduler should run.
+bool clock_handle();
+
+// Only interrupt the current cpu at `until`, if its clock event can do that.
+void clock_stop_tick(uint64_t until);
+
+void clock_start_tick();
+
+} // namespace x86
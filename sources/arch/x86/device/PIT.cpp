@@ -0,0 +1,68 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include "arch/x86/device/PIT.h"
+#include "arch/x86/x86.h"
+
+namespace x86
+{
+
+#define PIT_CHANNEL0_DATA 0x40
+#define PIT_CHANNEL2_DATA 0x42
+#define PIT_COMMAND 0x43
+#define PIT_CHANNEL2_GATE 0x61
+
+#define PIT_CHANNEL0_RATE_GENERATOR 0b00110100
+#define PIT_CHANNEL2_ONESHOT 0b10110000
+#define PIT_GATE_ENABLE (1 << 0)
+#define PIT_GATE_SPEAKER (1 << 1)
+#define PIT_GATE_OUTPUT (1 << 5)
+
+// The count is 16 bits wide, so that's the longest we can wait in one go.
+#define PIT_WAIT_MAX_MICROSECONDS 50000
+
+static void pit_wait_once(uint32_t microseconds)
+{
+    // Stay in 32 bits, there is no libgcc to do 64 bits divisions.
+    uint16_t count = (PIT_FREQUENCY / 1000) * microseconds / 1000;
+
+    uint8_t gate = in8(PIT_CHANNEL2_GATE) & ~(PIT_GATE_ENABLE | PIT_GATE_SPEAKER);
+    out8(PIT_CHANNEL2_GATE, gate);
+
+    out8(PIT_COMMAND, PIT_CHANNEL2_ONESHOT);
+    out8(PIT_CHANNEL2_DATA, count & 0xff);
+    out8(PIT_CHANNEL2_DATA, count >> 8);
+
+    // Rising the gate start the countdown, the output goes high when it's done.
+    out8(PIT_CHANNEL2_GATE, gate | PIT_GATE_ENABLE);
+
+    while (!(in8(PIT_CHANNEL2_GATE) & PIT_GATE_OUTPUT))
+    {
+        pause();
+    }
+
+    out8(PIT_CHANNEL2_GATE, gate);
+}
+
+void pit_wait(uint32_t microseconds)
+{
+    while (microseconds > PIT_WAIT_MAX_MICROSECONDS)
+    {
+        pit_wait_once(PIT_WAIT_MAX_MICROSECONDS);
+        microseconds -= PIT_WAIT_MAX_MICROSECONDS;
+    }
+
+    pit_wait_once(microseconds);
+}
+
+void pit_start_periodic(uint32_t frequency)
+{
+    uint16_t divisor = PIT_FREQUENCY / frequency;
+
+    out8(PIT_COMMAND, PIT_CHANNEL0_RATE_GENERATOR);
+    out8(PIT_CHANNEL0_DATA, divisor & 0xff);
+    out8(PIT_CHANNEL0_DATA, divisor >> 8);
+}
+
+} // namespace x86
@@ -0,0 +1,21 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Types.h>
+
+namespace x86
+{
+
+#define PIT_FREQUENCY 1193182
+
+// Busy wait using the channel 2 of the PIT, it doesn't need interrupts so it
+// can be used to time hardware during boot.
+void pit_wait(uint32_t microseconds);
+
+// Fire IRQ0 `frequency` times per seconds, using the channel 0.
+void pit_start_periodic(uint32_t frequency);
+
+} // namespace x86
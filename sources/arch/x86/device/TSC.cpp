@@ -0,0 +1,83 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libsystem/Logger.h>
+
+#include "arch/x86/device/PIT.h"
+#include "arch/x86/device/TSC.h"
+#include "arch/x86/x86.h"
+#include "system/System.h"
+
+namespace x86
+{
+
+#define TSC_CALIBRATION_MICROSECONDS 10000
+
+static uint64_t _base = 0;
+static uint64_t _first_tick = 0;
+static uint32_t _per_tick = 0;
+
+bool tsc_is_available()
+{
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(CPUID_FEATURES, eax, ebx, ecx, edx);
+
+    return edx & CPUID_FEATURES_EDX_TSC;
+}
+
+bool tsc_has_deadline()
+{
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(CPUID_FEATURES, eax, ebx, ecx, edx);
+
+    return ecx & CPUID_FEATURES_ECX_TSC_DEADLINE;
+}
+
+void tsc_calibrate(uint64_t first_tick)
+{
+    uint64_t start = rdtsc();
+    pit_wait(TSC_CALIBRATION_MICROSECONDS);
+    uint32_t elapsed = rdtsc() - start;
+
+    _per_tick = elapsed / (TSC_CALIBRATION_MICROSECONDS / (1000000 / TICK_FREQUENCY));
+    _base = rdtsc();
+    _first_tick = first_tick;
+
+    logger_info("The TSC runs at {}KHz", _per_tick * (TICK_FREQUENCY / 1000));
+}
+
+// There is no libgcc in the kernel, so divide 64 bits by 32 bits by hand,
+// two divl are enough since the remainder of the first one is below the divisor.
+static uint64_t divide(uint64_t dividend, uint32_t divisor)
+{
+    uint32_t high = dividend >> 32;
+    uint32_t low = dividend;
+
+    uint32_t quotient_high = high / divisor;
+    uint32_t remainder = high % divisor;
+    uint32_t quotient_low = low;
+
+    asm("divl %2"
+        : "+a"(quotient_low), "+d"(remainder)
+        : "rm"(divisor));
+
+    return ((uint64_t)quotient_high << 32) | quotient_low;
+}
+
+uint64_t tsc_ticks()
+{
+    return _first_tick + divide(rdtsc() - _base, _per_tick);
+}
+
+uint32_t tsc_cycles_per_tick()
+{
+    return _per_tick;
+}
+
+uint64_t tsc_at_tick(uint64_t tick)
+{
+    return _base + (tick - _first_tick) * _per_tick;
+}
+
+} // namespace x86
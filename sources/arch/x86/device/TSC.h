@@ -0,0 +1,29 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Types.h>
+
+namespace x86
+{
+
+bool tsc_is_available();
+
+// The local APIC timer can be armed with an absolute TSC value.
+bool tsc_has_deadline();
+
+// Measure the TSC against the PIT, its value at this point is `first_tick`.
+void tsc_calibrate(uint64_t first_tick);
+
+// Whole ticks elapsed since boot.
+uint64_t tsc_ticks();
+
+// Zero until it's calibrated.
+uint32_t tsc_cycles_per_tick();
+
+// The value of the TSC at the start of a tick.
+uint64_t tsc_at_tick(uint64_t tick);
+
+} // namespace x86
@@ -46,12 +46,11 @@ __interrupt_common:
     mov fs, ax
     mov gs, ax
 
-    push esp
-
     call interupts_handle
 
-    mov esp, eax
-
+; A new thread starts here, from the frame built by x86Thread::finalize().
+global __interrupt_return
+__interrupt_return:
     pop gs
     pop fs
     pop es
@@ -113,8 +112,13 @@ INTERRUPT_NOERR 45
 INTERRUPT_NOERR 46
 INTERRUPT_NOERR 47
 
+INTERRUPT_NOERR 48
+INTERRUPT_NOERR 50
+
 INTERRUPT_SYSCALL 128
 
+INTERRUPT_NOERR 255
+
 
 global __interrupt_vector
 
@@ -169,4 +173,9 @@ __interrupt_vector:
     INTERRUPT_NAME 46
     INTERRUPT_NAME 47
 
+    INTERRUPT_NAME 48
+    INTERRUPT_NAME 50
+
     INTERRUPT_NAME 128
+
+    INTERRUPT_NAME 255
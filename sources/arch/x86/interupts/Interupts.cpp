@@ -4,14 +4,21 @@
 
 #include <libsystem/Logger.h>
 
+#include "arch/x86/device/ClockEvent.h"
 #include "arch/x86/interupts/InteruptStackFrame.h"
 #include "arch/x86/interupts/Interupts.h"
+#include "arch/x86/interupts/LAPIC.h"
 #include "arch/x86/interupts/Pic.h"
+#include "arch/x86/paging/Paging.h"
+#include "arch/x86/paging/TLB.h"
+#include "arch/x86/tasking/FPU.h"
+#include "arch/x86/tasking/x86Thread.h"
 #include "arch/x86/x86.h"
 
 #include "arch/Arch.h"
 #include "system/System.h"
 #include "system/scheduling/Scheduling.h"
+#include "system/trace/Trace.h"
 
 x86::IdtEntry idt_entries[IDT_ENTRY_COUNT] = {};
 
@@ -42,18 +49,76 @@ void x86::interupts_initialise()
         idt_entries[i] = x86::IdtEntry::create(__interrupt_vector[i], 0x08, IDT_TRAPGATE);
     }
 
+    // The PIT may drive the scheduler, it must not be nested in an other interrupt.
+    idt_entries[32] = x86::IdtEntry::create(__interrupt_vector[32], 0x08, IDT_INTGATE);
+
+    // Local APIC timer and kick, they are only taken by the scheduler.
+    idt_entries[LAPIC_TIMER_VECTOR] = x86::IdtEntry::create(__interrupt_vector[48], 0x08, IDT_INTGATE);
+    idt_entries[KICK_VECTOR] = x86::IdtEntry::create(__interrupt_vector[49], 0x08, IDT_INTGATE);
+
     // Syscalls
-    idt_entries[128] = x86::IdtEntry::create(__interrupt_vector[48], 0x08, IDT_TRAPGATE);
+    idt_entries[128] = x86::IdtEntry::create(__interrupt_vector[50], 0x08, IDT_TRAPGATE);
+
+    idt_entries[LAPIC_SPURIOUS_VECTOR] = x86::IdtEntry::create(__interrupt_vector[51], 0x08, IDT_INTGATE);
 
     logger_info("Loading the IDT...");
-    x86::load_idt((uint32_t)&idt_descriptor);
+    interupts_load();
+
+    // The PIT is the clock of the boot processor until something better is found.
+    x86::clock_initialize_cpu();
 
     logger_info("We should get interupts now...");
     x86::sti();
 }
 
-extern "C" uint32_t interupts_handle(uint32_t esp, x86::InteruptStackFrame stackframe)
+static bool handle_page_fault(x86::InteruptStackFrame &stackframe)
+{
+    uintptr_t address = x86::cr2();
+    bool write = stackframe.err & PAGE_FAULT_WRITE;
+
+    if (address < USER_HALF_BASE)
+    {
+        return false;
+    }
+
+    if (address >= KERNEL_STACK_BASE && address < KERNEL_STACK_END)
+    {
+        // Stacks are always mapped, this is the guard page of the one below.
+        logger_fatal("Kernel stack overflow at {} eip={}", address, stackframe.eip);
+        return false;
+    }
+
+    return system::scheduling::running_process()->address_space().handle_page_fault(address, write);
+}
+
+void x86::interupts_load()
+{
+    x86::load_idt((uint32_t)&idt_descriptor);
+}
+
+extern "C" void interupts_handle(x86::InteruptStackFrame stackframe)
 {
+    x86::tlb_shootdown_handle();
+
+    if (stackframe.intno == 14)
+    {
+        if (handle_page_fault(stackframe))
+        {
+            return;
+        }
+
+        logger_fatal("Page fault at {} error={} eip={}", x86::cr2(), stackframe.err, stackframe.eip);
+        system::PANIC("Unhandled page fault!");
+    }
+
+    if (stackframe.intno == 7)
+    {
+        // Device not available, the running thread is using the FPU.
+        auto running = system::scheduling::running_thread();
+        x86::fpu_handle_trap(static_cast<x86::x86Thread &>(*running));
+
+        return;
+    }
 
     if (stackframe.intno < 32)
     {
@@ -61,14 +126,35 @@ extern "C" uint32_t interupts_handle(uint32_t esp, x86::InteruptStackFrame stack
         system::PANIC("CPU exception!");
     }
 
-    if (stackframe.intno == 32)
+    system::trace::record(system::trace::TraceEvent::IRQ_ENTER, stackframe.intno);
+
+    bool preempt = false;
+
+    if (stackframe.intno == 32 || stackframe.intno == LAPIC_TIMER_VECTOR)
+    {
+        preempt = x86::clock_handle();
+    }
+    else if (stackframe.intno == KICK_VECTOR)
     {
-        system::tick();
+        preempt = system::scheduling::should_preempt();
+    }
 
-        esp = system::scheduling::schedule(esp);
+    if (stackframe.intno < 48)
+    {
+        // Only the boot processor get interrupts from the PIC.
+        x86::pic_ack(stackframe.intno);
+    }
+    else if (stackframe.intno == LAPIC_TIMER_VECTOR || stackframe.intno == KICK_VECTOR)
+    {
+        x86::lapic_eoi();
     }
 
-    x86::pic_ack(stackframe.intno);
+    // Before the switch, the interrupt doesn't last while the next thread runs.
+    system::trace::record(system::trace::TraceEvent::IRQ_EXIT, stackframe.intno);
 
-    return esp;
+    // Acknowledged before, this thread may not come back here for a while.
+    if (preempt)
+    {
+        system::scheduling::schedule();
+    }
 }
\ No newline at end of file
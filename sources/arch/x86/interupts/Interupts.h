@@ -17,6 +17,9 @@ namespace x86
 #define IDT_TRAPGATE 0x8F
 #define IDT_ENTRY_COUNT 256
 
+// Sent by smp_kick().
+#define KICK_VECTOR 50
+
 struct __packed IdtDescriptor
 {
     uint16_t size;
@@ -47,4 +50,10 @@ struct __packed IdtEntry
 
 void interupts_initialise();
 
+// Load the IDT on the current cpu, the first one must call interupts_initialise().
+void interupts_load();
+
+// Pop an InteruptStackFrame and return from the interrupt.
+extern "C" void __interrupt_return();
+
 } // namespace x86
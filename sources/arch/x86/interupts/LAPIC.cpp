@@ -0,0 +1,157 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libsystem/Assert.h>
+#include <libsystem/Logger.h>
+
+#include "arch/x86/device/PIT.h"
+#include "arch/x86/interupts/LAPIC.h"
+#include "arch/x86/paging/Paging.h"
+#include "arch/x86/x86.h"
+
+namespace x86
+{
+
+#define LAPIC_REGISTERS_SIZE 0x400
+
+#define LAPIC_ID 0x20
+#define LAPIC_EOI 0xB0
+#define LAPIC_SPURIOUS 0xF0
+#define LAPIC_ICR_LOW 0x300
+#define LAPIC_ICR_HIGH 0x310
+#define LAPIC_TIMER 0x320
+#define LAPIC_TIMER_INITIAL 0x380
+#define LAPIC_TIMER_CURRENT 0x390
+#define LAPIC_TIMER_DIVIDE 0x3E0
+
+#define LAPIC_SOFTWARE_ENABLE (1 << 8)
+
+#define LAPIC_ICR_FIXED (0b000 << 8)
+#define LAPIC_ICR_INIT (0b101 << 8)
+#define LAPIC_ICR_STARTUP (0b110 << 8)
+#define LAPIC_ICR_LEVEL_ASSERT (1 << 14)
+#define LAPIC_ICR_PENDING (1 << 12)
+
+#define LAPIC_TIMER_MASKED (1 << 16)
+#define LAPIC_TIMER_ONESHOT (0b00 << 17)
+#define LAPIC_TIMER_PERIODIC (0b01 << 17)
+#define LAPIC_TIMER_TSC_DEADLINE (0b10 << 17)
+#define LAPIC_TIMER_DIVIDE_BY_16 0b0011
+
+#define LAPIC_CALIBRATION_MICROSECONDS 10000
+
+static volatile uint32_t *_lapic = nullptr;
+static uint32_t _timer_ticks_per_second = 0;
+
+static uint32_t lapic_read(uint32_t reg)
+{
+    return _lapic[reg / 4];
+}
+
+static void lapic_write(uint32_t reg, uint32_t value)
+{
+    _lapic[reg / 4] = value;
+}
+
+void lapic_initialize(uintptr_t physical_address)
+{
+    logger_info("Mapping the local APIC at {#x}...", physical_address);
+
+    _lapic = reinterpret_cast<volatile uint32_t *>(paging_map_device(physical_address, LAPIC_REGISTERS_SIZE));
+}
+
+bool lapic_is_available()
+{
+    return _lapic != nullptr;
+}
+
+void lapic_enable()
+{
+    lapic_write(LAPIC_SPURIOUS, LAPIC_SOFTWARE_ENABLE | LAPIC_SPURIOUS_VECTOR);
+}
+
+uint8_t lapic_id()
+{
+    return lapic_read(LAPIC_ID) >> 24;
+}
+
+void lapic_eoi()
+{
+    lapic_write(LAPIC_EOI, 0);
+}
+
+static void lapic_send_ipi(uint8_t apic_id, uint32_t command)
+{
+    lapic_write(LAPIC_ICR_HIGH, apic_id << 24);
+    lapic_write(LAPIC_ICR_LOW, command);
+
+    while (lapic_read(LAPIC_ICR_LOW) & LAPIC_ICR_PENDING)
+    {
+        pause();
+    }
+}
+
+void lapic_send_init(uint8_t apic_id)
+{
+    lapic_send_ipi(apic_id, LAPIC_ICR_INIT | LAPIC_ICR_LEVEL_ASSERT);
+}
+
+void lapic_send_startup(uint8_t apic_id, uintptr_t address)
+{
+    // The vector is the page number of the real mode entry point.
+    assert(address % 4096 == 0 && address < 0x100000);
+
+    lapic_send_ipi(apic_id, LAPIC_ICR_STARTUP | LAPIC_ICR_LEVEL_ASSERT | (address / 4096));
+}
+
+void lapic_send_fixed(uint8_t apic_id, uint8_t vector)
+{
+    lapic_send_ipi(apic_id, LAPIC_ICR_FIXED | LAPIC_ICR_LEVEL_ASSERT | vector);
+}
+
+void lapic_timer_calibrate()
+{
+    lapic_write(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_BY_16);
+    lapic_write(LAPIC_TIMER, LAPIC_TIMER_MASKED | LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_TIMER_INITIAL, 0xFFFFFFFF);
+
+    pit_wait(LAPIC_CALIBRATION_MICROSECONDS);
+
+    uint32_t elapsed = 0xFFFFFFFF - lapic_read(LAPIC_TIMER_CURRENT);
+    lapic_write(LAPIC_TIMER_INITIAL, 0);
+
+    _timer_ticks_per_second = elapsed * (1000000 / LAPIC_CALIBRATION_MICROSECONDS);
+
+    logger_info("The local APIC timer runs at {}Hz", _timer_ticks_per_second);
+}
+
+void lapic_timer_periodic(uint32_t frequency)
+{
+    assert(_timer_ticks_per_second != 0);
+
+    lapic_write(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_BY_16);
+    lapic_write(LAPIC_TIMER, LAPIC_TIMER_PERIODIC | LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_TIMER_INITIAL, _timer_ticks_per_second / frequency);
+}
+
+void lapic_timer_oneshot(uint32_t milliseconds)
+{
+    assert(_timer_ticks_per_second != 0);
+
+    lapic_write(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_BY_16);
+    lapic_write(LAPIC_TIMER, LAPIC_TIMER_ONESHOT | LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_TIMER_INITIAL, _timer_ticks_per_second / 1000 * milliseconds);
+}
+
+void lapic_timer_deadline(uint64_t deadline)
+{
+    lapic_write(LAPIC_TIMER, LAPIC_TIMER_TSC_DEADLINE | LAPIC_TIMER_VECTOR);
+
+    // The write to the LVT must be visible before the one to the MSR.
+    asm volatile("mfence" ::: "memory");
+
+    wrmsr(MSR_TSC_DEADLINE, deadline);
+}
+
+} // namespace x86
@@ -0,0 +1,48 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Types.h>
+
+namespace x86
+{
+
+#define LAPIC_TIMER_VECTOR 48
+#define LAPIC_SPURIOUS_VECTOR 255
+
+// Map the local APIC registers, they are at the same address on every cpu.
+void lapic_initialize(uintptr_t physical_address);
+
+bool lapic_is_available();
+
+// Software enable the local APIC of the current cpu.
+void lapic_enable();
+
+uint8_t lapic_id();
+
+void lapic_eoi();
+
+void lapic_send_init(uint8_t apic_id);
+
+void lapic_send_startup(uint8_t apic_id, uintptr_t address);
+
+// Send an interrupt to an other cpu, the handler must end with lapic_eoi().
+void lapic_send_fixed(uint8_t apic_id, uint8_t vector);
+
+// Measure the timer against the PIT, must be done once before starting it.
+void lapic_timer_calibrate();
+
+// The timer of the current cpu fires LAPIC_TIMER_VECTOR:
+
+// `frequency` times per seconds,
+void lapic_timer_periodic(uint32_t frequency);
+
+// once, in `milliseconds`,
+void lapic_timer_oneshot(uint32_t milliseconds);
+
+// or once the TSC reaches `deadline`, if tsc_has_deadline().
+void lapic_timer_deadline(uint64_t deadline);
+
+} // namespace x86
@@ -72,4 +72,19 @@ void pic_ack(int intno)
     out8(0x20, 0x20);
 }
 
+static uint16_t irq_port(int irq)
+{
+    return irq < 8 ? PIC1_DATA : PIC2_DATA;
+}
+
+void pic_mask(int irq)
+{
+    out8(irq_port(irq), in8(irq_port(irq)) | (1 << (irq % 8)));
+}
+
+void pic_unmask(int irq)
+{
+    out8(irq_port(irq), in8(irq_port(irq)) & ~(1 << (irq % 8)));
+}
+
 } // namespace x86
@@ -11,4 +11,8 @@ void pic_remap();
 
 void pic_ack(int intno);
 
+void pic_mask(int irq);
+
+void pic_unmask(int irq);
+
 } // namespace x86
@@ -0,0 +1,164 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libc/string.h>
+#include <libsystem/Assert.h>
+
+#include "arch/Arch.h"
+#include "arch/x86/memory/AddressSpace.h"
+#include "arch/x86/x86.h"
+
+#include "system/memory/Memory.h"
+
+using namespace system::memory;
+
+namespace x86
+{
+
+AddressSpace::AddressSpace()
+    : system::memory::AddressSpace(MemoryRegion::from_aligned_address(USER_HALF_BASE, USER_HALF_END - USER_HALF_BASE))
+{
+    _directory = reinterpret_cast<PageDirectory *>(alloc_region(1).base_address());
+
+    // The kernel half is shared, so its page tables don't have to be copied.
+    libc::memcpy(&_directory->entries[0],
+                 &kernel_page_directory().entries[0],
+                 KERNEL_PAGE_DIRECTORY_ENTRY_COUNT * sizeof(PageDirectoryEntry));
+
+    libc::memset(&_directory->entries[KERNEL_PAGE_DIRECTORY_ENTRY_COUNT], 0,
+                 (PAGE_DIRECTORY_ENTRY_COUNT - KERNEL_PAGE_DIRECTORY_ENTRY_COUNT) * sizeof(PageDirectoryEntry));
+
+    // The stack and device tables at the top are shared too.
+    libc::memcpy(&_directory->entries[PAGE_DIRECTORY_INDEX(KERNEL_STACK_BASE)],
+                 &kernel_page_directory().entries[PAGE_DIRECTORY_INDEX(KERNEL_STACK_BASE)],
+                 (PAGE_DIRECTORY_ENTRY_COUNT - PAGE_DIRECTORY_INDEX(KERNEL_STACK_BASE)) * sizeof(PageDirectoryEntry));
+}
+
+AddressSpace::~AddressSpace()
+{
+    unmap_all();
+
+    if (is_current_page_directory(*_directory))
+    {
+        load_page_directory(kernel_page_directory());
+    }
+
+    for (size_t i = KERNEL_PAGE_DIRECTORY_ENTRY_COUNT; i < PAGE_DIRECTORY_INDEX(USER_HALF_END); i++)
+    {
+        if (_directory->entries[i].present)
+        {
+            free_region(MemoryRegion::from_aligned_address(_directory->entries[i].address(), PAGE_SIZE));
+        }
+    }
+
+    free_region(MemoryRegion::from_aligned_address(reinterpret_cast<uintptr_t>(_directory), PAGE_SIZE));
+}
+
+PageTable *AddressSpace::page_table(uintptr_t address, bool create)
+{
+    PageDirectoryEntry &entry = _directory->entries[PAGE_DIRECTORY_INDEX(address)];
+
+    if (entry.present)
+    {
+        return reinterpret_cast<PageTable *>(entry.address());
+    }
+
+    if (!create)
+    {
+        return nullptr;
+    }
+
+    auto table = reinterpret_cast<PageTable *>(alloc_region(1).base_address());
+    libc::memset(table, 0, sizeof(PageTable));
+
+    entry = PageDirectoryEntry::create(reinterpret_cast<uintptr_t>(table), true, true);
+
+    return table;
+}
+
+void AddressSpace::map_page(uintptr_t virtual_address, uintptr_t physical_address, bool writable)
+{
+    assert(PAGE_DIRECTORY_INDEX(virtual_address) >= KERNEL_PAGE_DIRECTORY_ENTRY_COUNT);
+
+    TLBBatch batch;
+
+    bool were_enabled = arch::disable_interrupts();
+    _lock.acquire();
+
+    PageTable *table = page_table(virtual_address, true);
+    PageTableEntry &entry = table->entries[PAGE_TABLE_INDEX(virtual_address)];
+
+    // The entry may have been present and read-only before.
+    if (entry.present)
+    {
+        batch.add(virtual_address);
+    }
+
+    entry = PageTableEntry::create(physical_address, writable, true);
+
+    _lock.release();
+
+    tlb_shootdown(*_directory, batch);
+
+    arch::restore_interrupts(were_enabled);
+}
+
+void AddressSpace::unmap_page_unlocked(uintptr_t virtual_address, TLBBatch &batch)
+{
+    PageTable *table = page_table(virtual_address, false);
+
+    if (table && table->entries[PAGE_TABLE_INDEX(virtual_address)].present)
+    {
+        table->entries[PAGE_TABLE_INDEX(virtual_address)] = {};
+
+        batch.add(virtual_address);
+    }
+}
+
+void AddressSpace::unmap_page(uintptr_t virtual_address)
+{
+    TLBBatch batch;
+
+    bool were_enabled = arch::disable_interrupts();
+    _lock.acquire();
+
+    unmap_page_unlocked(virtual_address, batch);
+
+    _lock.release();
+
+    tlb_shootdown(*_directory, batch);
+
+    arch::restore_interrupts(were_enabled);
+}
+
+void AddressSpace::unmap_region(MemoryRegion virtual_region)
+{
+    TLBBatch batch;
+
+    bool were_enabled = arch::disable_interrupts();
+    _lock.acquire();
+
+    for (size_t i = 0; i < virtual_region.page_count(); i++)
+    {
+        unmap_page_unlocked(virtual_region.base_address() + i * PAGE_SIZE, batch);
+    }
+
+    _lock.release();
+
+    // A single shootdown for the whole region, which turn into a full flush
+    // when it's too large.
+    tlb_shootdown(*_directory, batch);
+
+    arch::restore_interrupts(were_enabled);
+}
+
+void AddressSpace::switch_to()
+{
+    if (!is_current_page_directory(*_directory))
+    {
+        load_page_directory(*_directory);
+    }
+}
+
+} // namespace x86
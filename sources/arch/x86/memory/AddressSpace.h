@@ -1,17 +1,40 @@
 #pragma once
 
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include "arch/x86/paging/Paging.h"
+#include "arch/x86/paging/TLB.h"
 #include "system/memory/AddressSpace.h"
 
 namespace x86
 {
 
-class AddressSpace
+class AddressSpace : public system::memory::AddressSpace
 {
 private:
-    /* data */
+    PageDirectory *_directory;
+    libruntime::SpinLock _lock;
+
+    PageTable *page_table(uintptr_t address, bool create);
+
+    void unmap_page_unlocked(uintptr_t virtual_address, TLBBatch &batch);
+
 public:
-    AddressSpace() {}
-    ~AddressSpace() {}
+    PageDirectory &directory() { return *_directory; }
+
+    AddressSpace();
+
+    ~AddressSpace();
+
+    void map_page(uintptr_t virtual_address, uintptr_t physical_address, bool writable);
+
+    void unmap_page(uintptr_t virtual_address);
+
+    void unmap_region(system::memory::MemoryRegion virtual_region);
+
+    void switch_to();
 };
 
 } // namespace x86
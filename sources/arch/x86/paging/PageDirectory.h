@@ -6,33 +6,50 @@
 namespace x86
 {
 
-class __packed PageDirectoryEntry
+#define PAGE_DIRECTORY_ENTRY_COUNT 1024
+#define PAGE_LARGE_SIZE (4096ul * 1024)
+
+struct __packed PageDirectoryEntry
 {
-private:
-    bool _present : 1;
-    bool _write : 1;
-    bool _user : 1;
-    bool _page_level_write_through : 1;
-    bool _page_level_cache_disable : 1;
-    bool _accessed : 1;
-    bool _ignored1 : 1;
-    bool _large_page : 1;
-    uint32_t _ignored2 : 4;
-    uint32_t _page_frame_number : 20;
-
-public:
-    PageDirectoryEntry() {}
-    ~PageDirectoryEntry() {}
+    bool present : 1;
+    bool write : 1;
+    bool user : 1;
+    bool page_level_write_through : 1;
+    bool page_level_cache_disable : 1;
+    bool accessed : 1;
+    bool ignored1 : 1;
+    bool large_page : 1;
+    uint32_t ignored2 : 4;
+    uint32_t page_frame_number : 20;
+
+    uintptr_t address() { return page_frame_number << 12; }
+
+    static PageDirectoryEntry create(uintptr_t address, bool write, bool user)
+    {
+        PageDirectoryEntry entry = {};
+
+        entry.present = true;
+        entry.write = write;
+        entry.user = user;
+        entry.page_frame_number = address >> 12;
+
+        return entry;
+    }
+
+    // Map 4MiB directly, without a page table, require CR4.PSE.
+    static PageDirectoryEntry create_large(uintptr_t address, bool write, bool user)
+    {
+        PageDirectoryEntry entry = create(address, write, user);
+
+        entry.large_page = true;
+
+        return entry;
+    }
 };
 
-class PageDirectory
+struct PageDirectory
 {
-private:
-    PageDirectoryEntry entries[1024];
-
-public:
-    PageDirectory() {}
-    ~PageDirectory() {}
+    PageDirectoryEntry entries[PAGE_DIRECTORY_ENTRY_COUNT];
 };
 
 static_assert(sizeof(PageDirectoryEntry) == 4);
@@ -6,33 +6,39 @@
 namespace x86
 {
 
-class __packed PageTableEntry
+#define PAGE_TABLE_ENTRY_COUNT 1024
+
+struct __packed PageTableEntry
 {
-private:
-    bool _present : 1;
-    bool _write : 1;
-    bool _user : 1;
-    bool _page_level_write_through : 1;
-    bool _page_level_cache_disable : 1;
-    bool _accessed : 1;
-    bool _dirty : 1;
-    bool _pat : 1;
-    uint32_t _ignored : 4;
-    uint32_t _page_frame_number : 20;
-
-public:
-    PageTableEntry() {}
-    ~PageTableEntry() {}
+    bool present : 1;
+    bool write : 1;
+    bool user : 1;
+    bool page_level_write_through : 1;
+    bool page_level_cache_disable : 1;
+    bool accessed : 1;
+    bool dirty : 1;
+    bool pat : 1;
+    uint32_t ignored : 4;
+    uint32_t page_frame_number : 20;
+
+    uintptr_t address() { return page_frame_number << 12; }
+
+    static PageTableEntry create(uintptr_t address, bool write, bool user)
+    {
+        PageTableEntry entry = {};
+
+        entry.present = true;
+        entry.write = write;
+        entry.user = user;
+        entry.page_frame_number = address >> 12;
+
+        return entry;
+    }
 };
 
-class PageTable
+struct PageTable
 {
-private:
-    PageTableEntry _entries[1024];
-
-public:
-    PageTable(/* args */) {}
-    ~PageTable() {}
+    PageTableEntry entries[PAGE_TABLE_ENTRY_COUNT];
 };
 
 static_assert(sizeof(PageTableEntry) == 4);
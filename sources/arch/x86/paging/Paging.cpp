@@ -0,0 +1,151 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libc/string.h>
+#include <libsystem/Assert.h>
+#include <libsystem/Logger.h>
+
+#include "arch/Arch.h"
+#include "arch/x86/paging/Paging.h"
+#include "arch/x86/paging/TLB.h"
+#include "arch/x86/x86.h"
+
+#include "system/memory/Memory.h"
+
+static x86::PageDirectory *_kernel_page_directory = nullptr;
+static x86::PageTable *_kernel_device_table = nullptr;
+static uintptr_t _kernel_device_next = KERNEL_DEVICE_BASE;
+
+static x86::PageTable *kernel_page_table(uintptr_t address)
+{
+    auto &entry = _kernel_page_directory->entries[PAGE_DIRECTORY_INDEX(address)];
+
+    if (!entry.present)
+    {
+        auto table = reinterpret_cast<x86::PageTable *>(system::memory::alloc_region(1).base_address());
+        libc::memset(table, 0, sizeof(x86::PageTable));
+
+        entry = x86::PageDirectoryEntry::create(reinterpret_cast<uintptr_t>(table), true, false);
+    }
+
+    assert(!entry.large_page);
+
+    return reinterpret_cast<x86::PageTable *>(entry.address());
+}
+
+// Identity map the region with 4MiB pages, the unaligned edges get page tables.
+static void kernel_identity_map(system::memory::MemoryRegion region)
+{
+    uintptr_t address = region.base_address();
+
+    while (address < region.end_address())
+    {
+        auto &entry = _kernel_page_directory->entries[PAGE_DIRECTORY_INDEX(address)];
+
+        if (address % PAGE_LARGE_SIZE == 0 &&
+            region.end_address() - address >= PAGE_LARGE_SIZE &&
+            !entry.present)
+        {
+            entry = x86::PageDirectoryEntry::create_large(address, true, false);
+            address += PAGE_LARGE_SIZE;
+        }
+        else if (entry.present && entry.large_page)
+        {
+            address += PAGE_LARGE_SIZE - address % PAGE_LARGE_SIZE;
+        }
+        else
+        {
+            kernel_page_table(address)->entries[PAGE_TABLE_INDEX(address)] = x86::PageTableEntry::create(address, true, false);
+            address += PAGE_SIZE;
+        }
+    }
+}
+
+void x86::paging_initialize()
+{
+    logger_info("Mapping the kernel half...");
+
+    auto directory_region = system::memory::alloc_region(1);
+    _kernel_page_directory = reinterpret_cast<PageDirectory *>(directory_region.base_address());
+    libc::memset(_kernel_page_directory, 0, sizeof(PageDirectory));
+
+    // Every page directory points to the kernel page tables, so they are
+    // never freed, and the kernel half must be complete before the first
+    // address space is created.
+    kernel_identity_map(arch::get_kernel_region());
+
+    // Skip the first page, dereferencing a nullptr should fault.
+    auto direct_map = arch::get_direct_map_region();
+    kernel_identity_map(system::memory::MemoryRegion::from_aligned_address(
+        direct_map.base_address() + PAGE_SIZE,
+        direct_map.size() - PAGE_SIZE));
+
+    // Created now, so address spaces can share it.
+    _kernel_device_table = reinterpret_cast<PageTable *>(system::memory::alloc_region(1).base_address());
+    libc::memset(_kernel_device_table, 0, sizeof(PageTable));
+
+    _kernel_page_directory->entries[PAGE_DIRECTORY_INDEX(KERNEL_DEVICE_BASE)] =
+        PageDirectoryEntry::create(reinterpret_cast<uintptr_t>(_kernel_device_table), true, false);
+
+    // Same for the stack tables, they start empty, every page is a guard page.
+    for (uintptr_t address = KERNEL_STACK_BASE; address < KERNEL_STACK_END; address += PAGE_LARGE_SIZE)
+    {
+        kernel_page_table(address);
+    }
+
+    logger_info("Enabling paging...");
+
+    set_cr4(cr4() | CR4_PSE);
+    load_page_directory(*_kernel_page_directory);
+    set_cr0(cr0() | CR0_PG);
+}
+
+uintptr_t x86::paging_map_device(uintptr_t physical_address, size_t size)
+{
+    auto region = system::memory::MemoryRegion::create_around_non_aligned_address(physical_address, size);
+
+    assert(_kernel_device_next + region.size() <= KERNEL_DEVICE_END);
+
+    uintptr_t virtual_address = _kernel_device_next;
+    _kernel_device_next += region.size();
+
+    for (size_t i = 0; i < region.page_count(); i++)
+    {
+        auto &entry = _kernel_device_table->entries[PAGE_TABLE_INDEX(virtual_address + i * PAGE_SIZE)];
+
+        entry = PageTableEntry::create(region.base_address() + i * PAGE_SIZE, true, false);
+        entry.page_level_cache_disable = true;
+    }
+
+    return virtual_address + (physical_address - region.base_address());
+}
+
+void x86::paging_map_kernel_stack(uintptr_t virtual_address, uintptr_t physical_address)
+{
+    assert(virtual_address >= KERNEL_STACK_BASE && virtual_address < KERNEL_STACK_END);
+
+    auto &entry = kernel_page_table(virtual_address)->entries[PAGE_TABLE_INDEX(virtual_address)];
+
+    assert(!entry.present);
+
+    // Non present entries are never cached, so no TLB has to be flushed.
+    entry = PageTableEntry::create(physical_address, true, false);
+}
+
+x86::PageDirectory &x86::kernel_page_directory()
+{
+    return *_kernel_page_directory;
+}
+
+void x86::load_page_directory(PageDirectory &directory)
+{
+    tlb_directory_loading(directory);
+    set_cr3(reinterpret_cast<uintptr_t>(&directory));
+    tlb_directory_loaded();
+}
+
+bool x86::is_current_page_directory(PageDirectory &directory)
+{
+    return cr3() == reinterpret_cast<uintptr_t>(&directory);
+}
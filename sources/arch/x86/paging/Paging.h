@@ -0,0 +1,62 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Types.h>
+
+#include "arch/x86/paging/PageDirectory.h"
+#include "arch/x86/paging/PageTable.h"
+
+namespace x86
+{
+
+#define PAGE_SIZE 4096ul
+
+// The first gigabyte of every address space is the kernel half. It maps
+// physical memory at the same address and is shared by every page directory.
+#define KERNEL_PAGE_DIRECTORY_ENTRY_COUNT 256
+
+// Page tables at the top of the address space, below the device table, where
+// kernel stacks are mapped.
+#define KERNEL_STACK_TABLE_COUNT 4
+
+// Userspace get what's left, minus the page tables at the top which are kept for the kernel.
+#define USER_HALF_BASE (KERNEL_PAGE_DIRECTORY_ENTRY_COUNT * PAGE_TABLE_ENTRY_COUNT * PAGE_SIZE)
+#define USER_HALF_END ((PAGE_DIRECTORY_ENTRY_COUNT - 1 - KERNEL_STACK_TABLE_COUNT) * PAGE_TABLE_ENTRY_COUNT * PAGE_SIZE)
+
+// Shared by every address space like the device table, so a thread keeps its
+// stack whatever address space is loaded. Pages which aren't mapped there
+// are the guard pages between stacks.
+#define KERNEL_STACK_BASE USER_HALF_END
+#define KERNEL_STACK_END KERNEL_DEVICE_BASE
+
+// The last page table is shared by every address space, devices which are
+// above the direct map, like the local APIC, are mapped there.
+#define KERNEL_DEVICE_BASE ((PAGE_DIRECTORY_ENTRY_COUNT - 1) * PAGE_TABLE_ENTRY_COUNT * PAGE_SIZE)
+#define KERNEL_DEVICE_END 0xFFFFF000ul
+
+#define PAGE_DIRECTORY_INDEX(__address) ((__address) >> 22)
+#define PAGE_TABLE_INDEX(__address) (((__address) >> 12) & 0x3ff)
+
+// Bits of the error code pushed by the cpu on a page fault.
+#define PAGE_FAULT_PRESENT (1 << 0)
+#define PAGE_FAULT_WRITE (1 << 1)
+#define PAGE_FAULT_USER (1 << 2)
+
+void paging_initialize();
+
+// Map device memory, uncached, in the kernel device table.
+uintptr_t paging_map_device(uintptr_t physical_address, size_t size);
+
+// Map a page in the kernel stack area, it's never unmapped.
+void paging_map_kernel_stack(uintptr_t virtual_address, uintptr_t physical_address);
+
+PageDirectory &kernel_page_directory();
+
+void load_page_directory(PageDirectory &directory);
+
+bool is_current_page_directory(PageDirectory &directory);
+
+} // namespace x86
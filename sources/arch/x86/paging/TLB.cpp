@@ -0,0 +1,254 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Pool.h>
+#include <libruntime/SpinLock.h>
+#include <libsystem/Assert.h>
+
+#include "arch/Arch.h"
+#include "arch/x86/paging/TLB.h"
+#include "arch/x86/smp/SMP.h"
+#include "arch/x86/x86.h"
+
+#include "system/System.h"
+#include "system/memory/Memory.h"
+
+using namespace system::memory;
+
+namespace x86
+{
+
+// Requests from other cpus are merged in the mailbox until its cpu get to
+// them, so a burst of unmaps cost the target cpu a single flush.
+struct TLBMailbox
+{
+    libruntime::SpinLock lock;
+    TLBBatch batch;
+    volatile bool pending;
+
+    // Generation of the last request posted, and of the last one handled.
+    volatile uint32_t posted;
+    volatile uint32_t acked;
+};
+
+// Frames waiting for every cpu to catch up. The node can't be stored in the
+// frame itself, a stale TLB entry on an other cpu may still let userspace
+// write to it.
+struct DeferredFrame : public libruntime::Pooled<DeferredFrame>
+{
+    MemoryRegion region;
+    uint32_t generation;
+    DeferredFrame *next;
+};
+
+static volatile uint32_t _generation = 0;
+static TLBMailbox _mailboxes[MAX_CPU_COUNT] = {};
+static PageDirectory *volatile _active_directories[MAX_CPU_COUNT] = {};
+
+static libruntime::SpinLock _deferred_lock;
+static DeferredFrame *_deferred_frames = nullptr;
+
+void TLBBatch::invalidate()
+{
+    if (_flush_all)
+    {
+        set_cr3(cr3());
+    }
+    else
+    {
+        for (size_t i = 0; i < _count; i++)
+        {
+            invlpg(_pages[i]);
+        }
+    }
+}
+
+static bool is_caught_up(uint32_t generation)
+{
+    for (size_t cpu = 0; cpu < MAX_CPU_COUNT; cpu++)
+    {
+        uint32_t acked = _mailboxes[cpu].acked;
+
+        if (acked != _mailboxes[cpu].posted && (int32_t)(acked - generation) < 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void reclaim_deferred_frames()
+{
+    DeferredFrame *reclaimable = nullptr;
+
+    _deferred_lock.acquire();
+
+    DeferredFrame **current = &_deferred_frames;
+
+    while (*current)
+    {
+        DeferredFrame *frame = *current;
+
+        if (is_caught_up(frame->generation))
+        {
+            *current = frame->next;
+
+            frame->next = reclaimable;
+            reclaimable = frame;
+        }
+        else
+        {
+            current = &frame->next;
+        }
+    }
+
+    _deferred_lock.release();
+
+    while (reclaimable)
+    {
+        DeferredFrame *frame = reclaimable;
+        reclaimable = frame->next;
+
+        free_region(frame->region);
+        delete frame;
+    }
+}
+
+void tlb_shootdown(PageDirectory &directory, TLBBatch &batch)
+{
+    if (batch.empty())
+    {
+        return;
+    }
+
+    bool were_enabled = arch::disable_interrupts();
+
+    int current_cpu = arch::get_current_cpu();
+
+    for (int cpu = 0; cpu < MAX_CPU_COUNT; cpu++)
+    {
+        if (_active_directories[cpu] != &directory)
+        {
+            continue;
+        }
+
+        if (cpu == current_cpu)
+        {
+            batch.invalidate();
+
+            continue;
+        }
+
+        TLBMailbox &mailbox = _mailboxes[cpu];
+
+        mailbox.lock.acquire();
+
+        mailbox.batch.merge(batch);
+        mailbox.posted = __atomic_add_fetch(&_generation, 1, __ATOMIC_SEQ_CST);
+        mailbox.pending = true;
+
+        mailbox.lock.release();
+
+        // An idle cpu may not have any interrupt for a while.
+        smp_kick(cpu);
+    }
+
+    arch::restore_interrupts(were_enabled);
+}
+
+static void ack_mailbox(bool flushed)
+{
+    bool were_enabled = arch::disable_interrupts();
+
+    TLBMailbox &mailbox = _mailboxes[arch::get_current_cpu()];
+
+    if (!mailbox.pending)
+    {
+        arch::restore_interrupts(were_enabled);
+
+        return;
+    }
+
+    mailbox.lock.acquire();
+
+    if (!flushed)
+    {
+        mailbox.batch.invalidate();
+    }
+
+    mailbox.batch.clear();
+    mailbox.pending = false;
+    mailbox.acked = mailbox.posted;
+
+    mailbox.lock.release();
+
+    reclaim_deferred_frames();
+
+    arch::restore_interrupts(were_enabled);
+}
+
+void tlb_shootdown_handle()
+{
+    ack_mailbox(false);
+}
+
+void tlb_shootdown_wait()
+{
+    uint32_t generation = __atomic_load_n(&_generation, __ATOMIC_SEQ_CST);
+
+    while (!is_caught_up(generation))
+    {
+        // The others were kicked, but one of them may be waiting on us.
+        tlb_shootdown_handle();
+        pause();
+    }
+}
+
+void tlb_free_after_shootdown(MemoryRegion region)
+{
+    uint32_t generation = __atomic_load_n(&_generation, __ATOMIC_SEQ_CST);
+
+    if (is_caught_up(generation))
+    {
+        free_region(region);
+
+        return;
+    }
+
+    auto frame = new DeferredFrame();
+
+    frame->region = region;
+    frame->generation = generation;
+
+    bool were_enabled = arch::disable_interrupts();
+    _deferred_lock.acquire();
+
+    frame->next = _deferred_frames;
+    _deferred_frames = frame;
+
+    _deferred_lock.release();
+
+    // Every cpu may have caught up since we checked, and then nobody would
+    // come back for the frame until the next shootdown.
+    reclaim_deferred_frames();
+
+    arch::restore_interrupts(were_enabled);
+}
+
+void tlb_directory_loading(PageDirectory &directory)
+{
+    // Published before the CR3 write, a shootdown which doesn't see it
+    // already changed the page tables we are about to walk.
+    _active_directories[arch::get_current_cpu()] = &directory;
+    __sync_synchronize();
+}
+
+void tlb_directory_loaded()
+{
+    // Reloading CR3 flushed everything the mailbox could ask for.
+    ack_mailbox(true);
+}
+
+} // namespace x86
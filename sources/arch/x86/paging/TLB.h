@@ -0,0 +1,83 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Types.h>
+
+#include "arch/x86/paging/PageDirectory.h"
+#include "system/memory/MemoryRegion.h"
+
+namespace x86
+{
+
+// Past this many pages reloading CR3 is cheaper than an invlpg per page.
+#define TLB_BATCH_PAGE_COUNT 32
+
+// Pages unmapped from the same page directory, invalidated all at once.
+class TLBBatch
+{
+private:
+    size_t _count = 0;
+    bool _flush_all = false;
+    uintptr_t _pages[TLB_BATCH_PAGE_COUNT];
+
+public:
+    bool empty() { return _count == 0 && !_flush_all; }
+
+    void add(uintptr_t address)
+    {
+        if (_count == TLB_BATCH_PAGE_COUNT)
+        {
+            _flush_all = true;
+        }
+        else if (!_flush_all)
+        {
+            _pages[_count++] = address;
+        }
+    }
+
+    void merge(TLBBatch &other)
+    {
+        if (other._flush_all)
+        {
+            _flush_all = true;
+        }
+
+        for (size_t i = 0; i < other._count; i++)
+        {
+            add(other._pages[i]);
+        }
+    }
+
+    void clear()
+    {
+        _count = 0;
+        _flush_all = false;
+    }
+
+    // Invalidate the pages on the current cpu only.
+    void invalidate();
+};
+
+// Invalidate the batch on every cpu using the directory. The current cpu is
+// done when this return, the others are only asked to, and they will do it
+// the next time they take an interrupt or load a page directory.
+void tlb_shootdown(PageDirectory &directory, TLBBatch &batch);
+
+// Run the invalidations other cpus asked for.
+void tlb_shootdown_handle();
+
+// Wait for every shootdown posted so far to be handled by its cpu.
+void tlb_shootdown_wait();
+
+// Give a frame which was mapped in userspace back to the memory allocator,
+// once no cpu could still be reaching it through a stale TLB entry.
+void tlb_free_after_shootdown(system::memory::MemoryRegion region);
+
+// Called by load_page_directory() around the CR3 write.
+void tlb_directory_loading(PageDirectory &directory);
+void tlb_directory_loaded();
+
+} // namespace x86
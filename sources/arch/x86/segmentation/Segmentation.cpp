@@ -4,33 +4,46 @@
 
 #include <libsystem/Logger.h>
 
+#include "arch/Arch.h"
 #include "arch/x86/segmentation/Segmentation.h"
 #include "arch/x86/x86.h"
 
-x86::Tss tss;
+#include "system/System.h"
 
-x86::GdtEntry gdt_entries[GDT_ENTRY_COUNT] = {};
+// Every cpu has its own GDT, so each one can point to its own TSS.
+x86::Tss tss[MAX_CPU_COUNT] = {};
 
-x86::GdtDescriptor gdt_descriptor = {
-    .size = sizeof(x86::GdtEntry) * GDT_ENTRY_COUNT,
-    .offset = (uint32_t)&gdt_entries[0],
-};
+x86::GdtEntry gdt_entries[MAX_CPU_COUNT][GDT_ENTRY_COUNT] = {};
+
+x86::GdtDescriptor gdt_descriptor[MAX_CPU_COUNT] = {};
 
 void x86::segmentation_initialize()
 {
-    tss = x86::Tss();
+    int cpu = arch::get_current_cpu();
+
+    tss[cpu] = x86::Tss();
+    tss[cpu].ss0 = 0x10;
+    tss[cpu].iomap_base = sizeof(x86::Tss);
+
+    logger_info("Populating the GDT of cpu {}...", cpu);
+
+    auto entries = gdt_entries[cpu];
 
-    logger_info("Populating the GDT...");
+    entries[0] = x86::GdtEntry::create(0, 0, 0, 0);
+    entries[1] = x86::GdtEntry::create(0, 0xffffffff, GDT_PRESENT | GDT_READWRITE | GDT_EXECUTABLE, GDT_FLAGS);
+    entries[2] = x86::GdtEntry::create(0, 0xffffffff, GDT_PRESENT | GDT_READWRITE, GDT_FLAGS);
+    entries[3] = x86::GdtEntry::create(0, 0xffffffff, GDT_PRESENT | GDT_READWRITE | GDT_USER | GDT_EXECUTABLE, GDT_FLAGS);
+    entries[4] = x86::GdtEntry::create(0, 0xffffffff, GDT_PRESENT | GDT_READWRITE | GDT_USER, GDT_FLAGS);
+    entries[5] = x86::GdtEntry::create(((uintptr_t)&tss[cpu]), sizeof(x86::Tss), GDT_TSS, TSS_FLAGS);
 
-    gdt_entries[0] = x86::GdtEntry::create(0, 0, 0, 0);
-    gdt_entries[1] = x86::GdtEntry::create(0, 0xffffffff, GDT_PRESENT | GDT_READWRITE | GDT_EXECUTABLE, GDT_FLAGS);
-    gdt_entries[2] = x86::GdtEntry::create(0, 0xffffffff, GDT_PRESENT | GDT_READWRITE, GDT_FLAGS);
-    gdt_entries[3] = x86::GdtEntry::create(0, 0xffffffff, GDT_PRESENT | GDT_READWRITE | GDT_USER | GDT_EXECUTABLE, GDT_FLAGS);
-    gdt_entries[4] = x86::GdtEntry::create(0, 0xffffffff, GDT_PRESENT | GDT_READWRITE | GDT_USER, GDT_FLAGS);
-    gdt_entries[5] = x86::GdtEntry::create(((uintptr_t)&tss), sizeof(x86::Tss), GDT_PRESENT | GDT_EXECUTABLE | GDT_ACCESSED, TSS_FLAGS);
+    gdt_descriptor[cpu] = {
+        .size = sizeof(x86::GdtEntry) * GDT_ENTRY_COUNT,
+        .offset = (uint32_t)&entries[0],
+    };
 
     logger_info("Loading the GDT...");
-    x86::load_gdt((uint32_t)&gdt_descriptor);
+    x86::load_gdt((uint32_t)&gdt_descriptor[cpu]);
+    x86::load_tss(GDT_TSS_SELECTOR);
 
     logger_info("Memory segmentation loaded.");
 }
@@ -11,6 +11,7 @@ namespace x86
 {
 
 #define GDT_ENTRY_COUNT 6
+#define GDT_TSS_SELECTOR 0x28
 
 #define GDT_PRESENT 0b10010000
 #define GDT_USER 0b01100000
@@ -18,6 +19,9 @@ namespace x86
 #define GDT_READWRITE 0b00000010
 #define GDT_ACCESSED 0b00000001
 
+// Present, system descriptor, available 32 bit TSS.
+#define GDT_TSS 0b10001001
+
 #define GDT_FLAGS 0b1100
 #define TSS_FLAGS 0
 
@@ -84,6 +88,7 @@ struct __packed GdtEntry
     }
 };
 
+// Load a GDT and a TSS for the current cpu.
 void segmentation_initialize();
 
 } // namespace x86
@@ -0,0 +1,173 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libc/string.h>
+#include <libsystem/Logger.h>
+
+#include "arch/Arch.h"
+#include "arch/x86/device/ClockEvent.h"
+#include "arch/x86/device/PIT.h"
+#include "arch/x86/interupts/Interupts.h"
+#include "arch/x86/interupts/LAPIC.h"
+#include "arch/x86/paging/Paging.h"
+#include "arch/x86/segmentation/Segmentation.h"
+#include "arch/x86/smp/SMP.h"
+#include "arch/x86/tasking/FPU.h"
+#include "arch/x86/x86.h"
+
+#include "system/System.h"
+#include "system/acpi/ACPI.h"
+#include "system/tasking/Tasking.h"
+
+extern "C" uint8_t __trampoline_start[];
+extern "C" uint8_t __trampoline_end[];
+extern "C" uint32_t __trampoline_page_directory;
+extern "C" uint32_t __trampoline_stack;
+extern "C" uint32_t __trampoline_entry;
+
+namespace x86
+{
+
+static int _cpu_count = 1;
+
+// Every apic id maps to the boot processor until smp_initialize() run.
+static uint8_t _apic_id_to_cpu[256] = {};
+static uint8_t _cpu_to_apic_id[MAX_CPU_COUNT] = {};
+
+static volatile bool _ap_started = false;
+
+// Where a variable of the trampoline ended up once it was copied.
+static uint32_t *trampoline_variable(uint32_t *variable)
+{
+    uintptr_t offset = reinterpret_cast<uintptr_t>(variable) - reinterpret_cast<uintptr_t>(__trampoline_start);
+
+    return reinterpret_cast<uint32_t *>(SMP_TRAMPOLINE_ADDRESS + offset);
+}
+
+// Called by the trampoline, on the stack of the idle thread of this cpu.
+static void smp_ap_entry()
+{
+    lapic_enable();
+
+    segmentation_initialize();
+    interupts_load();
+    fpu_initialize_cpu();
+
+    // The trampoline loaded CR3 by itself, let the TLB shootdown code know.
+    load_page_directory(kernel_page_directory());
+
+    logger_info("Cpu {} is up.", arch::get_current_cpu());
+
+    _ap_started = true;
+
+    clock_initialize_cpu();
+    sti();
+
+    arch::idle();
+}
+
+static bool smp_start_cpu(uint8_t apic_id, int cpu)
+{
+    _apic_id_to_cpu[apic_id] = cpu;
+    _cpu_to_apic_id[cpu] = apic_id;
+
+    auto idle_thread = system::tasking::create_idle_thread(cpu);
+
+    *trampoline_variable(&__trampoline_stack) = idle_thread->stack().get_pointer();
+    *trampoline_variable(&__trampoline_entry) = reinterpret_cast<uintptr_t>(smp_ap_entry);
+
+    _ap_started = false;
+
+    // INIT-SIPI-SIPI, with the delays from the MultiProcessor Specification.
+    lapic_send_init(apic_id);
+    pit_wait(10000);
+
+    lapic_send_startup(apic_id, SMP_TRAMPOLINE_ADDRESS);
+    pit_wait(200);
+
+    if (!_ap_started)
+    {
+        lapic_send_startup(apic_id, SMP_TRAMPOLINE_ADDRESS);
+    }
+
+    for (int i = 0; i < SMP_STARTUP_TIMEOUT_MILLISECONDS && !_ap_started; i++)
+    {
+        pit_wait(1000);
+    }
+
+    return _ap_started;
+}
+
+void smp_initialize()
+{
+    if (system::acpi::local_apic_address() == 0)
+    {
+        logger_warn("No MADT found, only the boot processor will be used.");
+        return;
+    }
+
+    lapic_initialize(system::acpi::local_apic_address());
+    lapic_enable();
+    lapic_timer_calibrate();
+
+    // Before starting the other cpus, so they can use the TSC deadline mode.
+    clock_initialize();
+
+    uint8_t boot_apic_id = lapic_id();
+    _cpu_to_apic_id[0] = boot_apic_id;
+
+    libc::memcpy(reinterpret_cast<void *>(SMP_TRAMPOLINE_ADDRESS), __trampoline_start, __trampoline_end - __trampoline_start);
+    *trampoline_variable(&__trampoline_page_directory) = reinterpret_cast<uintptr_t>(&kernel_page_directory());
+
+    for (size_t i = 0; i < system::acpi::processor_count(); i++)
+    {
+        uint8_t apic_id = system::acpi::processor_apic_id(i);
+
+        if (apic_id == boot_apic_id)
+        {
+            continue;
+        }
+
+        logger_info("Starting the processor with local APIC {}...", apic_id);
+
+        if (smp_start_cpu(apic_id, _cpu_count))
+        {
+            _cpu_count++;
+        }
+        else
+        {
+            logger_warn("The processor with local APIC {} didn't start.", apic_id);
+            _apic_id_to_cpu[apic_id] = 0;
+        }
+    }
+
+    logger_info("{} cpus online.", _cpu_count);
+}
+
+int smp_cpu_count()
+{
+    return _cpu_count;
+}
+
+int smp_current_cpu()
+{
+    if (!lapic_is_available())
+    {
+        return 0;
+    }
+
+    return _apic_id_to_cpu[lapic_id()];
+}
+
+void smp_kick(int cpu)
+{
+    if (cpu >= _cpu_count || cpu == smp_current_cpu())
+    {
+        return;
+    }
+
+    lapic_send_fixed(_cpu_to_apic_id[cpu], KICK_VECTOR);
+}
+
+} // namespace x86
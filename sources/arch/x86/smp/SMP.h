@@ -0,0 +1,30 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Types.h>
+
+namespace x86
+{
+
+// Must be kept in sync with Trampoline.s
+#define SMP_TRAMPOLINE_ADDRESS 0x8000
+
+// Time given to an application processor to reach smp_ap_entry().
+#define SMP_STARTUP_TIMEOUT_MILLISECONDS 100
+
+// Wake up every processor listed in the MADT, they start running their idle
+// thread and get work from the scheduler.
+void smp_initialize();
+
+int smp_cpu_count();
+
+int smp_current_cpu();
+
+// Interrupt an other cpu with KICK_VECTOR, so it looks at its run queue and
+// its TLB mailbox, even if it is idle with its tick stopped.
+void smp_kick(int cpu);
+
+} // namespace x86
@@ -0,0 +1,99 @@
+; Copyright © 2019-2020 N. Van Bossuyt.                                        ;
+; This code is licensed under the 3-Clause BSD License.                        ;
+; See: LICENSE.md                                                              ;
+
+; Application processors start in real mode at SMP_TRAMPOLINE_ADDRESS. This
+; code is copied there before waking them up, so every address it uses is
+; computed from that base instead of where it was linked.
+
+SMP_TRAMPOLINE_ADDRESS equ 0x8000
+
+%define TRAMPOLINE(__symbol) (SMP_TRAMPOLINE_ADDRESS + ((__symbol) - __trampoline_start))
+
+section .text
+
+global __trampoline_start
+global __trampoline_end
+global __trampoline_page_directory
+global __trampoline_stack
+global __trampoline_entry
+
+bits 16
+__trampoline_start:
+    cli
+    cld
+
+    xor ax, ax
+    mov ds, ax
+
+    lgdt [TRAMPOLINE(__trampoline_gdt_descriptor)]
+
+    mov eax, cr0
+    or eax, 1
+    mov cr0, eax
+
+    jmp dword 0x08:TRAMPOLINE(__trampoline_protected)
+
+bits 32
+__trampoline_protected:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+
+    ; Same paging setup as the boot processor, with 4MiB pages.
+    mov eax, cr4
+    or eax, 0x10
+    mov cr4, eax
+
+    mov eax, [TRAMPOLINE(__trampoline_page_directory)]
+    mov cr3, eax
+
+    mov eax, cr0
+    or eax, 0x80000000
+    mov cr0, eax
+
+    ; Same FPU and SSE setup as the boot processor.
+    mov eax, cr0
+    and eax, ~(1 << 2)
+    or eax, (1 << 1) | (1 << 5)
+    mov cr0, eax
+
+    mov eax, cr4
+    or eax, (1 << 9) | (1 << 10)
+    mov cr4, eax
+
+    fninit
+
+    mov esp, [TRAMPOLINE(__trampoline_stack)]
+    xor ebp, ebp
+
+    mov eax, [TRAMPOLINE(__trampoline_entry)]
+    call eax
+
+.hang:
+    cli
+    hlt
+    jmp .hang
+
+align 8
+__trampoline_gdt:
+    dq 0x0000000000000000 ; null
+    dq 0x00CF9A000000FFFF ; kernel code
+    dq 0x00CF92000000FFFF ; kernel data
+
+__trampoline_gdt_descriptor:
+    dw __trampoline_gdt_descriptor - __trampoline_gdt - 1
+    dd TRAMPOLINE(__trampoline_gdt)
+
+; Filled by smp_initialize() in the copy of the trampoline.
+__trampoline_page_directory:
+    dd 0
+__trampoline_stack:
+    dd 0
+__trampoline_entry:
+    dd 0
+
+__trampoline_end:
@@ -0,0 +1,78 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libc/string.h>
+#include <libsystem/Assert.h>
+
+#include "arch/Arch.h"
+#include "arch/x86/tasking/FPU.h"
+#include "arch/x86/tasking/x86Thread.h"
+#include "arch/x86/x86.h"
+
+#include "system/System.h"
+
+namespace x86
+{
+
+// The state is only saved when a thread which used the FPU is switched
+// out, and only loaded when it uses it again. A thread which never touches
+// it never pays for it, not even a save.
+static x86Thread *_fpu_owners[MAX_CPU_COUNT] = {};
+
+alignas(16) static FpuState _fpu_initial_state;
+
+void fpu_initialize()
+{
+    // Boot.s enabled the FPU and SSE, and nobody used it since.
+    fninit();
+    fxsave(&_fpu_initial_state);
+
+    fpu_initialize_cpu();
+}
+
+void fpu_initialize_cpu()
+{
+    set_cr0(cr0() | CR0_TS);
+}
+
+void fpu_switch_out(x86Thread &thread)
+{
+    int cpu = arch::get_current_cpu();
+
+    if (_fpu_owners[cpu] == nullptr)
+    {
+        return;
+    }
+
+    assert(_fpu_owners[cpu] == &thread);
+
+    fxsave(thread.fpu_state().necked());
+    _fpu_owners[cpu] = nullptr;
+
+    set_cr0(cr0() | CR0_TS);
+}
+
+void fpu_handle_trap(x86Thread &thread)
+{
+    int cpu = arch::get_current_cpu();
+
+    assert(_fpu_owners[cpu] == nullptr);
+
+    if (!thread.fpu_state())
+    {
+        auto state = libruntime::own<FpuState>();
+
+        assert(reinterpret_cast<uintptr_t>(state.necked()) % 16 == 0);
+
+        libc::memcpy(state.necked(), &_fpu_initial_state, sizeof(FpuState));
+        thread.fpu_state() = state;
+    }
+
+    clts();
+    fxrstor(thread.fpu_state().necked());
+
+    _fpu_owners[cpu] = &thread;
+}
+
+} // namespace x86
@@ -0,0 +1,39 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Types.h>
+
+namespace x86
+{
+
+class x86Thread;
+
+#define FPU_STATE_SIZE 512
+
+// What FXSAVE stores: the x87, MMX and SSE registers. The kernel heap
+// aligns it on 16 bytes, as FXSAVE wants.
+struct FpuState
+{
+    uint8_t buffer[FPU_STATE_SIZE];
+};
+
+// Save the state of a clean FPU for the threads to start from, then do the
+// same as fpu_initialize_cpu().
+void fpu_initialize();
+
+// Set CR0.TS, the first thread to use the FPU on this cpu traps.
+void fpu_initialize_cpu();
+
+// Must be called with interrupts disabled when a thread stops running on
+// the current cpu. If it used the FPU, its state is saved and CR0.TS set
+// again, so it can resume on any cpu.
+void fpu_switch_out(x86Thread &thread);
+
+// Handle the #NM trap: load the state of the running thread, the first time
+// it uses the FPU it starts from a clean one.
+void fpu_handle_trap(x86Thread &thread);
+
+} // namespace x86
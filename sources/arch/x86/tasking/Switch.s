@@ -0,0 +1,27 @@
+; Copyright © 2019-2020 N. Van Bossuyt.                                        ;
+; This code is licensed under the 3-Clause BSD License.                        ;
+; See: LICENSE.md                                                              ;
+
+; void switch_stack(uintptr_t *from, uintptr_t to)
+;
+; Only the registers the caller expects to be preserved are saved, the rest of
+; the context is either already on the stack of an interrupt, or dead.
+global switch_stack
+switch_stack:
+    mov eax, [esp + 4]
+    mov edx, [esp + 8]
+
+    push ebp
+    push ebx
+    push esi
+    push edi
+
+    mov [eax], esp
+    mov esp, edx
+
+    pop edi
+    pop esi
+    pop ebx
+    pop ebp
+
+    ret
@@ -5,6 +5,8 @@
 /* See: LICENSE.md                                                            */
 
 #include "arch/x86/interupts/InteruptStackFrame.h"
+#include "arch/x86/interupts/Interupts.h"
+#include "arch/x86/tasking/FPU.h"
 #include "system/tasking/Process.h"
 #include "system/tasking/Thread.h"
 
@@ -13,7 +15,13 @@ namespace x86
 
 class x86Thread : public system::tasking::Thread
 {
+private:
+    // Only allocated once the thread uses the FPU.
+    libruntime::OwnPtr<FpuState> _fpu_state;
+
 public:
+    libruntime::OwnPtr<FpuState> &fpu_state() { return _fpu_state; }
+
     x86Thread(
         libruntime::RefPtr<system::tasking::Process> process,
         system::tasking::ThreadEntry entry) : Thread(process, entry) {}
@@ -24,9 +32,6 @@ public:
     {
         stack().push(0);
         stack().push(0);
-
-        userstack().push(0);
-        userstack().push(0);
     }
 
     void finalize()
@@ -36,7 +41,9 @@ public:
         if (promotion() == system::tasking::Promotion::USER)
         {
             stack().push((uint32_t)0x20);
-            stack().push(userstack().get_pointer());
+            // Leave room for the same two zeros as on the kernel stack, the
+            // pages are demand-zero so they don't have to be written.
+            stack().push(userstack_top() - 2 * sizeof(uint32_t));
             stack().push((uint32_t)0x202);
 
             frame.cs = 0x18;
@@ -60,6 +67,15 @@ public:
         frame.eflags = 0x202;
 
         stack().push(&frame);
+
+        // Switched to like any other thread, it "returns" to the end of the
+        // interrupt handler, which pops the frame. Then ebp, ebx, esi and edi.
+        stack().push(reinterpret_cast<uintptr_t>(__interrupt_return));
+
+        for (int i = 0; i < 4; i++)
+        {
+            stack().push((uint32_t)0);
+        }
     }
 };
 
@@ -55,19 +55,163 @@ static inline void out32(uint16_t port, uint32_t data)
                  : "a"(data), "d"(port));
 }
 
-static inline void raise_irq1()
+static inline void cli(void) { asm volatile("cli" ::: "memory"); }
+
+static inline void sti(void) { asm volatile("sti" ::: "memory"); }
+
+static inline void hlt(void) { asm volatile("hlt"); }
+
+static inline void pause(void) { asm volatile("pause"); }
+
+static inline uint32_t eflags()
 {
-    asm volatile("int $32");
+    uint32_t flags;
+    asm volatile("pushf\n"
+                 "pop %0"
+                 : "=r"(flags));
+    return flags;
 }
 
-static inline void cli(void) { asm volatile("cli"); }
+#define EFLAGS_IF (1 << 9)
 
-static inline void sti(void) { asm volatile("sti"); }
+static inline uint32_t cr0()
+{
+    uint32_t value;
+    asm volatile("mov %%cr0, %0"
+                 : "=r"(value));
+    return value;
+}
 
-static inline void hlt(void) { asm volatile("hlt"); }
+static inline void set_cr0(uint32_t value)
+{
+    asm volatile("mov %0, %%cr0" ::"r"(value)
+                 : "memory");
+}
+
+#define CR0_MP (1u << 1)
+#define CR0_EM (1u << 2)
+#define CR0_TS (1u << 3)
+#define CR0_NE (1u << 5)
+#define CR0_PG (1u << 31)
+
+// Clear CR0.TS, without a read-modify-write of CR0.
+static inline void clts()
+{
+    asm volatile("clts" ::
+                     : "memory");
+}
+
+// The area must be 512 bytes, aligned on 16 bytes.
+static inline void fxsave(void *area)
+{
+    asm volatile("fxsave (%0)" ::"r"(area)
+                 : "memory");
+}
+
+static inline void fxrstor(void *area)
+{
+    asm volatile("fxrstor (%0)" ::"r"(area)
+                 : "memory");
+}
+
+static inline void fninit()
+{
+    asm volatile("fninit");
+}
+
+static inline uint32_t cr2()
+{
+    uint32_t value;
+    asm volatile("mov %%cr2, %0"
+                 : "=r"(value));
+    return value;
+}
+
+static inline uint32_t cr3()
+{
+    uint32_t value;
+    asm volatile("mov %%cr3, %0"
+                 : "=r"(value));
+    return value;
+}
+
+static inline void set_cr3(uint32_t value)
+{
+    asm volatile("mov %0, %%cr3" ::"r"(value)
+                 : "memory");
+}
+
+static inline uint32_t cr4()
+{
+    uint32_t value;
+    asm volatile("mov %%cr4, %0"
+                 : "=r"(value));
+    return value;
+}
+
+static inline void set_cr4(uint32_t value)
+{
+    asm volatile("mov %0, %%cr4" ::"r"(value)
+                 : "memory");
+}
+
+#define CR4_PSE (1u << 4)
+#define CR4_OSFXSR (1u << 9)
+#define CR4_OSXMMEXCPT (1u << 10)
+
+static inline void invlpg(uintptr_t address)
+{
+    asm volatile("invlpg (%0)" ::"r"(address)
+                 : "memory");
+}
+
+static inline void cpuid(uint32_t leaf, uint32_t &eax, uint32_t &ebx, uint32_t &ecx, uint32_t &edx)
+{
+    asm volatile("cpuid"
+                 : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                 : "a"(leaf), "c"(0));
+}
+
+#define CPUID_FEATURES 1
+#define CPUID_FEATURES_EDX_TSC (1 << 4)
+#define CPUID_FEATURES_ECX_TSC_DEADLINE (1 << 24)
+
+static inline uint64_t rdtsc()
+{
+    uint32_t low, high;
+    asm volatile("rdtsc"
+                 : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+static inline uint64_t rdmsr(uint32_t msr)
+{
+    uint32_t low, high;
+    asm volatile("rdmsr"
+                 : "=a"(low), "=d"(high)
+                 : "c"(msr));
+    return ((uint64_t)high << 32) | low;
+}
+
+static inline void wrmsr(uint32_t msr, uint64_t value)
+{
+    asm volatile("wrmsr" ::"c"(msr), "a"((uint32_t)value), "d"((uint32_t)(value >> 32))
+                 : "memory");
+}
+
+#define MSR_TSC_DEADLINE 0x6E0
 
 extern "C" void load_gdt(uint32_t gdt);
 
+static inline void load_tss(uint16_t selector)
+{
+    asm volatile("ltr %0" ::"r"(selector));
+}
+
 extern "C" void load_idt(uint32_t idt);
 
+// Push the callee-saved registers, save the stack pointer in `from` and pop
+// them back from the `to` stack.
+extern "C" void switch_stack(uintptr_t *from, uintptr_t to);
+
 } // namespace x86
@@ -0,0 +1,43 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Types.h>
+
+namespace libmath
+{
+
+// 64 bits division on 32 bits targets, without the helpers from libgcc which
+// the kernel isn't linked with. Bit by bit, so keep it out of the hot paths.
+inline uint64_t divide(uint64_t dividend, uint64_t divisor)
+{
+    if (divisor == 0)
+    {
+        return 0;
+    }
+
+    uint64_t quotient = 0;
+    uint64_t remainder = 0;
+
+    for (int bit = 63; bit >= 0; bit--)
+    {
+        remainder = (remainder << 1) | ((dividend >> bit) & 1);
+
+        if (remainder >= divisor)
+        {
+            remainder -= divisor;
+            quotient |= 1ull << bit;
+        }
+    }
+
+    return quotient;
+}
+
+inline uint64_t percent(uint64_t part, uint64_t total)
+{
+    return divide(part * 100, total);
+}
+
+} // namespace libmath
@@ -0,0 +1,97 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Macros.h>
+#include <libruntime/Types.h>
+#include <libsystem/Assert.h>
+
+namespace libruntime
+{
+
+#define ARENA_ALIGNMENT 16
+
+// Bump pointer allocator, everything allocated from it is released at once
+// by resetting the arena, or when the Scope which was opened before goes away.
+class Arena
+{
+private:
+    byte *_buffer;
+    size_t _size;
+    size_t _used;
+
+public:
+    class Scope
+    {
+    private:
+        Arena &_arena;
+        size_t _mark;
+
+    public:
+        Scope(Arena &arena) : _arena(arena), _mark(arena.mark()) {}
+
+        ~Scope() { _arena.reset(_mark); }
+
+        __noncopyable(Scope);
+        __nonmovable(Scope);
+    };
+
+    size_t size() { return _size; }
+    size_t used() { return _used; }
+
+    Arena(size_t size) : _buffer(new byte[size]), _size(size), _used(0) {}
+
+    ~Arena() { delete[] _buffer; }
+
+    __noncopyable(Arena);
+    __nonmovable(Arena);
+
+    void *alloc(size_t size)
+    {
+        size_t base = __align_up(_used, ARENA_ALIGNMENT);
+
+        assert(base + size <= _size);
+
+        _used = base + size;
+
+        return &_buffer[base];
+    }
+
+    size_t mark() { return _used; }
+
+    void reset(size_t mark = 0)
+    {
+        assert(mark <= _used);
+
+        _used = mark;
+    }
+};
+
+// Inherit from ArenaAllocated to create objects with `new (arena) T(...)`.
+// Deleting them, directly or through OwnPtr and RefPtr, run the destructor but
+// leave the memory to the arena.
+class ArenaAllocated
+{
+public:
+    static void *operator new(size_t size, Arena &arena)
+    {
+        return arena.alloc(size);
+    }
+
+    static void operator delete(void *ptr)
+    {
+        __unused(ptr);
+    }
+
+    // Only called if the constructor throws, which never happen, but the
+    // placement form must have a matching delete.
+    static void operator delete(void *ptr, Arena &arena)
+    {
+        __unused(ptr);
+        __unused(arena);
+    }
+};
+
+} // namespace libruntime
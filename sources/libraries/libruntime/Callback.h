@@ -1,6 +1,7 @@
 #pragma once
 
 #include <libruntime/OwnPtr.h>
+#include <libruntime/Pool.h>
 #include <libruntime/Move.h>
 #include <libsystem/Assert.h>
 
@@ -23,13 +24,13 @@ private:
     };
 
     template <typename T>
-    class CallbackWrapper final : public AbstractCallbackWrapper
+    class CallbackWrapper final : public AbstractCallbackWrapper, public Pooled<CallbackWrapper<T>>
     {
     private:
         T _callback;
 
     public:
-        CallbackWrapper(T &&callback) : _callback(callback) {}
+        CallbackWrapper(T &callback) : _callback(callback) {}
         CallbackWrapper(const CallbackWrapper &) = delete;
         CallbackWrapper &operator=(const CallbackWrapper &) = delete;
 
@@ -0,0 +1,21 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+namespace libruntime
+{
+
+// Tell the cpu we are busy waiting, so it stops speculating on the loop and
+// lets its sibling hyperthread run.
+static inline void cpu_relax()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    asm volatile("pause" ::: "memory");
+#else
+    asm volatile("" ::: "memory");
+#endif
+}
+
+} // namespace libruntime
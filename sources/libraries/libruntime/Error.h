@@ -7,16 +7,19 @@
 namespace libruntime
 {
 
-#define ERROR_LIST(__ITEM)  \
-    __ITEM(SUCCEED)         \
-    __ITEM(NOT_IMPLEMENTED) \
-    __ITEM(READ_ONLY)       \
-    __ITEM(WRITE_ONLY)      \
-    __ITEM(END_OF_STREAM)   \
-    __ITEM(NO_SUCH_THREAD)  \
-    __ITEM(NO_CHILD_THREAD) \
-    __ITEM(NO_SUCH_PROCESS) \
-    __ITEM(NO_CHILD_PROCESS)
+#define ERROR_LIST(__ITEM)   \
+    __ITEM(SUCCEED)          \
+    __ITEM(NOT_IMPLEMENTED)  \
+    __ITEM(READ_ONLY)        \
+    __ITEM(WRITE_ONLY)       \
+    __ITEM(END_OF_STREAM)    \
+    __ITEM(NO_SUCH_THREAD)   \
+    __ITEM(NO_CHILD_THREAD)  \
+    __ITEM(NO_SUCH_PROCESS)  \
+    __ITEM(NO_CHILD_PROCESS) \
+    __ITEM(BAD_ADDRESS)      \
+    __ITEM(ALREADY_MAPPED)   \
+    __ITEM(OUT_OF_MEMORY)
 
 enum class Error
 {
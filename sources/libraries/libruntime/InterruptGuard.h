@@ -0,0 +1,29 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Macros.h>
+#include <libsystem/__plugs_processor__.h>
+
+namespace libruntime
+{
+
+// Interrupts are disabled for as long as the guard lives, and put back the
+// way they were when it goes away.
+class InterruptGuard
+{
+private:
+    bool _were_enabled;
+
+public:
+    InterruptGuard() : _were_enabled(__plugs__::interrupts_disable()) {}
+
+    ~InterruptGuard() { __plugs__::interrupts_restore(_were_enabled); }
+
+    __noncopyable(InterruptGuard);
+    __nonmovable(InterruptGuard);
+};
+
+} // namespace libruntime
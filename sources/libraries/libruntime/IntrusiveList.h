@@ -0,0 +1,205 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Iteration.h>
+#include <libruntime/Types.h>
+#include <libsystem/Assert.h>
+
+namespace libruntime
+{
+
+// Embedded in the objects which can be put in an IntrusiveList, an object
+// can be in as many lists at once as it has nodes.
+struct IntrusiveListNode
+{
+    IntrusiveListNode *prev = nullptr;
+    IntrusiveListNode *next = nullptr;
+    bool linked = false;
+};
+
+// Doubly linked list going through a node embedded in its items, nothing is
+// allocated and an item is unlinked in O(1). The list doesn't own its items,
+// they must be removed before they go away.
+//
+// An all zero IntrusiveList is a valid empty list.
+template <typename T, IntrusiveListNode T::*Node>
+class IntrusiveList
+{
+private:
+    IntrusiveListNode *_head = nullptr;
+    IntrusiveListNode *_tail = nullptr;
+    size_t _count = 0;
+
+    // Any suitably aligned address works to find where the node is in a T,
+    // but not nullptr, which the compiler may assume is never dereferenced.
+    static constexpr size_t FAKE_ITEM_ADDRESS = 0x1000;
+
+    static IntrusiveListNode &node_of(T &item)
+    {
+        return item.*Node;
+    }
+
+    static T *item_of(IntrusiveListNode *node)
+    {
+        if (node == nullptr)
+        {
+            return nullptr;
+        }
+
+        size_t offset = reinterpret_cast<size_t>(&(reinterpret_cast<T *>(FAKE_ITEM_ADDRESS)->*Node)) - FAKE_ITEM_ADDRESS;
+
+        return reinterpret_cast<T *>(reinterpret_cast<byte *>(node) - offset);
+    }
+
+public:
+    size_t count() { return _count; }
+    bool empty() { return _count == 0; }
+    bool any() { return _count > 0; }
+
+    IntrusiveList() {}
+
+    ~IntrusiveList() {}
+
+    static bool is_linked(T &item)
+    {
+        return node_of(item).linked;
+    }
+
+    T *first() { return item_of(_head); }
+
+    T *last() { return item_of(_tail); }
+
+    T *next(T &item) { return item_of(node_of(item).next); }
+
+    void push(T &item)
+    {
+        IntrusiveListNode &node = node_of(item);
+
+        assert(!node.linked);
+
+        node.prev = nullptr;
+        node.next = _head;
+        node.linked = true;
+
+        if (_head)
+        {
+            _head->prev = &node;
+        }
+        else
+        {
+            _tail = &node;
+        }
+
+        _head = &node;
+        _count++;
+    }
+
+    void push_back(T &item)
+    {
+        IntrusiveListNode &node = node_of(item);
+
+        assert(!node.linked);
+
+        node.prev = _tail;
+        node.next = nullptr;
+        node.linked = true;
+
+        if (_tail)
+        {
+            _tail->next = &node;
+        }
+        else
+        {
+            _head = &node;
+        }
+
+        _tail = &node;
+        _count++;
+    }
+
+    // The item must be in this list.
+    void remove(T &item)
+    {
+        IntrusiveListNode &node = node_of(item);
+
+        assert(node.linked);
+
+        if (node.prev)
+        {
+            node.prev->next = node.next;
+        }
+        else
+        {
+            _head = node.next;
+        }
+
+        if (node.next)
+        {
+            node.next->prev = node.prev;
+        }
+        else
+        {
+            _tail = node.prev;
+        }
+
+        node.prev = nullptr;
+        node.next = nullptr;
+        node.linked = false;
+
+        _count--;
+    }
+
+    // Return nullptr if the list is empty.
+    T *pop()
+    {
+        T *item = first();
+
+        if (item)
+        {
+            remove(*item);
+        }
+
+        return item;
+    }
+
+    // Unlink the first item matching the predicate, or return nullptr.
+    template <typename Predicate>
+    T *take_if(Predicate predicate)
+    {
+        for (T *item = first(); item; item = next(*item))
+        {
+            if (predicate(*item))
+            {
+                remove(*item);
+
+                return item;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // The callback may remove the item it is given.
+    template <typename Callback>
+    void foreach (Callback callback)
+    {
+        T *item = first();
+
+        while (item)
+        {
+            T *next_item = next(*item);
+
+            if (callback(*item) == Iteration::STOP)
+            {
+                return;
+            }
+
+            item = next_item;
+        }
+    }
+};
+
+} // namespace libruntime
@@ -6,6 +6,7 @@
 
 #include <libruntime/Iteration.h>
 #include <libruntime/Move.h>
+#include <libruntime/Pool.h>
 #include <libruntime/Types.h>
 #include <libsystem/Assert.h>
 
@@ -13,14 +14,14 @@ namespace libruntime
 {
 
 template <typename T>
-struct LinkedListItem
+struct LinkedListItem : public Pooled<LinkedListItem<T>>
 {
     T value;
 
     LinkedListItem *prev;
     LinkedListItem *next;
 
-    LinkedListItem(T value) : value(value), prev(nullptr), next(nullptr) {}
+    LinkedListItem(T value) : value(libruntime::move(value)), prev(nullptr), next(nullptr) {}
 };
 
 template <typename T>
@@ -101,7 +102,7 @@ public:
         }
     }
 
-    T push(T value)
+    T &push(T value)
     {
         LinkedListItem<T> *item = new LinkedListItem<T>(libruntime::move(value));
 
@@ -125,7 +126,7 @@ public:
         return item->value;
     }
 
-    T push_back(T value)
+    T &push_back(T value)
     {
         LinkedListItem<T> *item = new LinkedListItem<T>(libruntime::move(value));
 
@@ -235,6 +236,48 @@ public:
         }
     }
 
+    // Unlink the first item matching the predicate and give its value, or a
+    // default constructed T if there is none.
+    template <typename Predicate>
+    T take_if(Predicate predicate)
+    {
+        LinkedListItem<T> *current = _head;
+
+        while (current && !predicate(current->value))
+        {
+            current = current->next;
+        }
+
+        if (!current)
+        {
+            return T{};
+        }
+
+        if (current->prev != nullptr)
+        {
+            current->prev->next = current->next;
+        }
+        else
+        {
+            _head = current->next;
+        }
+
+        if (current->next != nullptr)
+        {
+            current->next->prev = current->prev;
+        }
+        else
+        {
+            _tail = current->prev;
+        }
+
+        _count--;
+
+        T value = move(current->value);
+        delete current;
+        return value;
+    }
+
     bool containe(T value)
     {
         LinkedListItem<T> *current = _head;
@@ -0,0 +1,111 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/CpuRelax.h>
+#include <libruntime/Types.h>
+#include <libsystem/__plugs_processor__.h>
+
+namespace libruntime
+{
+
+// Queue lock, each waiter spins on its own node, so releasing the lock only
+// touches the cache line of the next one in line. It is fair like a TicketLock.
+//
+// The node must stay alive and untouched from acquire() to release(), a node
+// per cpu is enough if the lock is always held with interrupts disabled.
+//
+// An all zero McsLock is a valid unlocked lock.
+class McsLock
+{
+public:
+    struct Node
+    {
+        Node *volatile next;
+        volatile bool waiting;
+    };
+
+private:
+    Node *volatile _tail = nullptr;
+
+public:
+    McsLock() {}
+    ~McsLock() {}
+
+    void acquire(Node &node)
+    {
+        node.next = nullptr;
+        node.waiting = true;
+
+        Node *previous = __atomic_exchange_n(&_tail, &node, __ATOMIC_ACQ_REL);
+
+        if (previous == nullptr)
+        {
+            return;
+        }
+
+        __atomic_store_n(&previous->next, &node, __ATOMIC_RELEASE);
+
+        while (__atomic_load_n(&node.waiting, __ATOMIC_ACQUIRE))
+        {
+            cpu_relax();
+        }
+    }
+
+    void release(Node &node)
+    {
+        Node *next = __atomic_load_n(&node.next, __ATOMIC_ACQUIRE);
+
+        if (next == nullptr)
+        {
+            Node *expected = &node;
+
+            if (__atomic_compare_exchange_n(&_tail, &expected, nullptr, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+            {
+                return;
+            }
+
+            // Someone is queuing up behind us, wait for it to link itself.
+            while ((next = __atomic_load_n(&node.next, __ATOMIC_ACQUIRE)) == nullptr)
+            {
+                cpu_relax();
+            }
+        }
+
+        __atomic_store_n(&next->waiting, false, __ATOMIC_RELEASE);
+    }
+
+    bool is_acquired()
+    {
+        return _tail != nullptr;
+    }
+
+    bool try_acquire(Node &node)
+    {
+        node.next = nullptr;
+        node.waiting = false;
+
+        Node *expected = nullptr;
+
+        return __atomic_compare_exchange_n(&_tail, &expected, &node, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+    }
+
+    // Return whether interrupts were enabled, to be given back to release_irqrestore().
+    bool acquire_irqsave(Node &node)
+    {
+        bool were_enabled = __plugs__::interrupts_disable();
+        acquire(node);
+
+        return were_enabled;
+    }
+
+    void release_irqrestore(Node &node, bool were_enabled)
+    {
+        release(node);
+        __plugs__::interrupts_restore(were_enabled);
+    }
+};
+
+} // namespace libruntime
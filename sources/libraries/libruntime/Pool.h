@@ -0,0 +1,156 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Types.h>
+#include <libsystem/Assert.h>
+#include <libsystem/__plugs__.h>
+
+namespace libruntime
+{
+
+#define POOL_CHUNK_SIZE 32
+#define POOL_CPU_COUNT 8
+
+// Fixed size object pool, free slots are recycled in O(1) through intrusive
+// free lists and chunks are never given back to the heap.
+//
+// Each cpu has its own free list, only touched with interrupts disabled, so
+// no lock is ever taken. A slot freed on another cpu just joins that cpu's list.
+//
+// An all zero Pool is a valid empty pool, so it can be used as a static
+// before any constructor has run.
+template <typename T>
+class Pool
+{
+private:
+    union Slot
+    {
+        Slot *next;
+        alignas(T) byte storage[sizeof(T)];
+    };
+
+    struct FreeList
+    {
+        Slot *head;
+        size_t allocated;
+        size_t used;
+    };
+
+    FreeList _free_lists[POOL_CPU_COUNT] = {};
+
+    FreeList &current_free_list()
+    {
+        size_t cpu = __plugs__::current_cpu();
+
+        assert(cpu < POOL_CPU_COUNT);
+
+        return _free_lists[cpu];
+    }
+
+    void grow(FreeList &free_list)
+    {
+        Slot *chunk = new Slot[POOL_CHUNK_SIZE];
+
+        for (size_t i = 0; i < POOL_CHUNK_SIZE; i++)
+        {
+            chunk[i].next = free_list.head;
+            free_list.head = &chunk[i];
+        }
+
+        free_list.allocated += POOL_CHUNK_SIZE;
+    }
+
+public:
+    size_t allocated()
+    {
+        size_t allocated = 0;
+
+        for (size_t i = 0; i < POOL_CPU_COUNT; i++)
+        {
+            allocated += _free_lists[i].allocated;
+        }
+
+        return allocated;
+    }
+
+    size_t used()
+    {
+        // Per cpu counts wrap around when slots migrate, only their sum means something.
+        size_t used = 0;
+
+        for (size_t i = 0; i < POOL_CPU_COUNT; i++)
+        {
+            used += _free_lists[i].used;
+        }
+
+        return used;
+    }
+
+    Pool() {}
+
+    ~Pool() {}
+
+    void *alloc()
+    {
+        bool were_enabled = __plugs__::interrupts_disable();
+
+        FreeList &free_list = current_free_list();
+
+        if (free_list.head == nullptr)
+        {
+            grow(free_list);
+        }
+
+        Slot *slot = free_list.head;
+        free_list.head = slot->next;
+        free_list.used++;
+
+        __plugs__::interrupts_restore(were_enabled);
+
+        return slot->storage;
+    }
+
+    void free(void *ptr)
+    {
+        Slot *slot = reinterpret_cast<Slot *>(ptr);
+
+        bool were_enabled = __plugs__::interrupts_disable();
+
+        FreeList &free_list = current_free_list();
+
+        slot->next = free_list.head;
+        free_list.head = slot;
+        free_list.used--;
+
+        __plugs__::interrupts_restore(were_enabled);
+    }
+};
+
+// Inherit from Pooled<T> to allocate every T from the same pool, delete, and
+// so OwnPtr and RefPtr, will give the memory back to it.
+template <typename T>
+class Pooled
+{
+private:
+    static inline Pool<T> _pool{};
+
+public:
+    static Pool<T> &pool() { return _pool; }
+
+    static void *operator new(size_t size)
+    {
+        assert(size == sizeof(T));
+
+        return _pool.alloc();
+    }
+
+    static void operator delete(void *ptr)
+    {
+        _pool.free(ptr);
+    }
+};
+
+} // namespace libruntime
@@ -4,25 +4,88 @@
 /* This code is licensed under the 3-Clause BSD License.                      */
 /* See: LICENSE.md                                                            */
 
+#include <libruntime/SpinLock.h>
 #include <libsystem/Assert.h>
 
 namespace libruntime
 {
 
+// Shared by an object and all the WeakPtr pointing to it, it outlives the
+// object and only tells it is gone once it is.
 template <typename T>
-class RefCounted
+class WeakLink
 {
-    // FIXME: make ref and deref atomics
+private:
+    int _refcount;
+    SpinLock _lock;
+    T *_object;
+
+public:
+    WeakLink(T *object) : _refcount(1), _object(object) {}
+
+    ~WeakLink() {}
+
+    void ref()
+    {
+        __atomic_add_fetch(&_refcount, 1, __ATOMIC_RELAXED);
+    }
+
+    void deref()
+    {
+        if (__atomic_sub_fetch(&_refcount, 1, __ATOMIC_ACQ_REL) == 0)
+        {
+            delete this;
+        }
+    }
+
+    // Return the object with a new reference on it, or nullptr if it is, or
+    // is about to be, destroyed.
+    T *try_ref()
+    {
+        bool were_enabled = _lock.acquire_irqsave();
+
+        T *object = _object;
+
+        if (object && !object->try_ref())
+        {
+            object = nullptr;
+        }
+
+        _lock.release_irqrestore(were_enabled);
+
+        return object;
+    }
+
+    // Called by the object once its last reference is gone, it stays alive
+    // until this returns, try_ref() has to be done with it by then.
+    void detach()
+    {
+        bool were_enabled = _lock.acquire_irqsave();
+
+        _object = nullptr;
+
+        _lock.release_irqrestore(were_enabled);
+    }
+};
 
+// The count is updated atomically, so references can be taken and dropped
+// from any cpu, and an object is destroyed exactly once. Taking a reference
+// doesn't need to order anything, the one dropping the last reference must
+// see everything the other owners did before destroying the object.
+template <typename T>
+class RefCounted
+{
 private:
     int _refcount;
     bool _orphan;
+    WeakLink<T> *_weak_link;
 
 public:
     RefCounted()
     {
         _refcount = 1;
         _orphan = false;
+        _weak_link = nullptr;
     }
 
     virtual ~RefCounted()
@@ -43,22 +106,51 @@ public:
     {
         if (!_orphan)
         {
-            assert(_refcount > 0);
+            int refcount = __atomic_fetch_add(&_refcount, 1, __ATOMIC_RELAXED);
 
-            _refcount++;
+            assert(refcount > 0);
         }
     }
 
+    // Like ref(), but fail if the last reference is already gone.
+    bool try_ref()
+    {
+        if (_orphan)
+        {
+            return true;
+        }
+
+        int refcount = __atomic_load_n(&_refcount, __ATOMIC_RELAXED);
+
+        do
+        {
+            if (refcount == 0)
+            {
+                return false;
+            }
+        } while (!__atomic_compare_exchange_n(&_refcount, &refcount, refcount + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+        return true;
+    }
+
     void deref()
     {
         if (!_orphan)
         {
-            assert(_refcount > 0);
+            int refcount = __atomic_sub_fetch(&_refcount, 1, __ATOMIC_RELEASE);
 
-            _refcount--;
+            assert(refcount >= 0);
 
-            if (_refcount == 0)
+            if (refcount == 0)
             {
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+                if (_weak_link)
+                {
+                    _weak_link->detach();
+                    _weak_link->deref();
+                }
+
                 delete static_cast<T *>(this);
             }
         }
@@ -68,13 +160,38 @@ public:
     {
         if (!_orphan)
         {
-            return _refcount;
+            return __atomic_load_n(&_refcount, __ATOMIC_RELAXED);
         }
         else
         {
             return 0;
         }
     }
+
+    // Created on first use, the caller must hold a reference on the object.
+    WeakLink<T> *weak_link()
+    {
+        WeakLink<T> *link = __atomic_load_n(&_weak_link, __ATOMIC_ACQUIRE);
+
+        if (link)
+        {
+            return link;
+        }
+
+        link = new WeakLink<T>(static_cast<T *>(this));
+
+        WeakLink<T> *expected = nullptr;
+
+        if (!__atomic_compare_exchange_n(&_weak_link, &expected, link, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            // An other cpu was faster.
+            delete link;
+
+            return expected;
+        }
+
+        return link;
+    }
 };
 
 } // namespace libruntime
@@ -10,6 +10,9 @@
 namespace libruntime
 {
 
+template <typename T>
+class RefPtrView;
+
 template <typename T>
 class RefPtr
 {
@@ -41,11 +44,21 @@ public:
     template <typename U>
     RefPtr(RefPtr<U> &&other) : _ptr(static_cast<T *>(other.give_ref())) {}
 
+    // Keeping a borrowed object around takes a reference on it.
+    RefPtr(RefPtrView<T> view) : _ptr(view.necked())
+    {
+        if (_ptr)
+        {
+            _ptr->ref();
+        }
+    }
+
     RefPtr &operator=(nullptr_t)
     {
         if (_ptr)
         {
             necked()->deref();
+            _ptr = nullptr;
         }
 
         return *this;
@@ -129,8 +142,8 @@ public:
     T &operator*() { return *_ptr; }
     const T &operator*() const { return *_ptr; }
 
-    bool operator==(RefPtr<T> other) const { return _ptr == other._ptr; }
-    bool operator!=(RefPtr<T> other) const { return _ptr != other._ptr; }
+    bool operator==(const RefPtr<T> &other) const { return _ptr == other._ptr; }
+    bool operator!=(const RefPtr<T> &other) const { return _ptr != other._ptr; }
     bool operator==(T *other) const { return _ptr == other; }
     bool operator!=(T *other) const { return _ptr != other; }
 
@@ -169,6 +182,39 @@ public:
     }
 };
 
+// Borrow an object from whoever hold a reference on it, without touching its
+// refcount. The owner must outlive the view, so it can be passed down to
+// callees, but not kept once they return.
+template <typename T>
+class RefPtrView
+{
+private:
+    T *_ptr;
+
+public:
+    RefPtrView() : _ptr(nullptr) {}
+    RefPtrView(nullptr_t) : _ptr(nullptr) {}
+    RefPtrView(T &object) : _ptr(&object) {}
+
+    RefPtrView(RefPtr<T> &ptr) : _ptr(ptr.necked()) {}
+
+    template <typename U>
+    RefPtrView(RefPtr<U> &ptr) : _ptr(static_cast<T *>(ptr.necked())) {}
+
+    T *operator->() { return _ptr; }
+    T &operator*() { return *_ptr; }
+
+    bool operator==(RefPtrView other) const { return _ptr == other._ptr; }
+    bool operator!=(RefPtrView other) const { return _ptr != other._ptr; }
+    bool operator==(const T *other) const { return _ptr == other; }
+    bool operator!=(const T *other) const { return _ptr != other; }
+
+    operator bool() const { return _ptr != nullptr; }
+    bool operator!() const { return _ptr == nullptr; }
+
+    T *necked() { return _ptr; }
+};
+
 template <typename T>
 inline RefPtr<T> adopt(T &object)
 {
@@ -4,9 +4,20 @@
 /* This code is licensed under the 3-Clause BSD License.                      */
 /* See: LICENSE.md                                                            */
 
+#include <libruntime/CpuRelax.h>
+#include <libruntime/Types.h>
+#include <libsystem/__plugs_processor__.h>
+
 namespace libruntime
 {
 
+#define SPINLOCK_BACKOFF_MAX 64
+
+// Test and test-and-set lock, waiters only read the lock while it's held and
+// back off exponentially, so the cache line isn't bounced between cpus.
+// It's not fair, use a TicketLock or a McsLock when there is contention.
+//
+// Take it with acquire_irqsave() if an interrupt handler may take it too.
 class SpinLock
 {
 private:
@@ -18,18 +29,28 @@ public:
 
     void acquire()
     {
-        while (!__sync_bool_compare_and_swap(&_locked, false, true))
+        size_t backoff = 1;
+
+        while (!try_acquire())
         {
-            //FIXME: don't burn  the CPU
-        }
+            while (_locked)
+            {
+                for (size_t i = 0; i < backoff; i++)
+                {
+                    cpu_relax();
+                }
 
-        __sync_synchronize();
+                if (backoff < SPINLOCK_BACKOFF_MAX)
+                {
+                    backoff *= 2;
+                }
+            }
+        }
     }
 
     void release()
     {
-        __sync_synchronize();
-        _locked = false;
+        __atomic_store_n(&_locked, false, __ATOMIC_RELEASE);
     }
 
     bool is_acquired()
@@ -39,15 +60,22 @@ public:
 
     bool try_acquire()
     {
-        if (__sync_bool_compare_and_swap(&_locked, 0, 1))
-        {
-            __sync_synchronize();
-            return true;
-        }
-        else
-        {
-            return false;
-        }
+        return !__atomic_exchange_n(&_locked, true, __ATOMIC_ACQUIRE);
+    }
+
+    // Return whether interrupts were enabled, to be given back to release_irqrestore().
+    bool acquire_irqsave()
+    {
+        bool were_enabled = __plugs__::interrupts_disable();
+        acquire();
+
+        return were_enabled;
+    }
+
+    void release_irqrestore(bool were_enabled)
+    {
+        release();
+        __plugs__::interrupts_restore(were_enabled);
     }
 };
 
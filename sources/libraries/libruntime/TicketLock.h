@@ -0,0 +1,83 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/CpuRelax.h>
+#include <libruntime/Types.h>
+#include <libsystem/__plugs_processor__.h>
+
+namespace libruntime
+{
+
+// Fair spin lock, waiters are served in the order they arrived. They still all
+// spin on the same cache line, so a McsLock scale better under heavy contention.
+//
+// An all zero TicketLock is a valid unlocked lock.
+class TicketLock
+{
+private:
+    volatile uint32_t _next = 0;
+    volatile uint32_t _serving = 0;
+
+public:
+    TicketLock() {}
+    ~TicketLock() {}
+
+    void acquire()
+    {
+        uint32_t ticket = __atomic_fetch_add(&_next, 1, __ATOMIC_RELAXED);
+
+        while (true)
+        {
+            uint32_t serving = __atomic_load_n(&_serving, __ATOMIC_ACQUIRE);
+
+            if (serving == ticket)
+            {
+                return;
+            }
+
+            // Wait longer the further back in the line we are.
+            for (uint32_t i = 0; i < ticket - serving; i++)
+            {
+                cpu_relax();
+            }
+        }
+    }
+
+    void release()
+    {
+        __atomic_store_n(&_serving, _serving + 1, __ATOMIC_RELEASE);
+    }
+
+    bool is_acquired()
+    {
+        return _next != _serving;
+    }
+
+    bool try_acquire()
+    {
+        uint32_t serving = __atomic_load_n(&_serving, __ATOMIC_RELAXED);
+        uint32_t expected = serving;
+
+        return __atomic_compare_exchange_n(&_next, &expected, serving + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+    }
+
+    // Return whether interrupts were enabled, to be given back to release_irqrestore().
+    bool acquire_irqsave()
+    {
+        bool were_enabled = __plugs__::interrupts_disable();
+        acquire();
+
+        return were_enabled;
+    }
+
+    void release_irqrestore(bool were_enabled)
+    {
+        release();
+        __plugs__::interrupts_restore(were_enabled);
+    }
+};
+
+} // namespace libruntime
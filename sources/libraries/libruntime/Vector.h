@@ -38,7 +38,7 @@ public:
     {
         clear();
 
-        delete _storage;
+        delete[] _storage;
     }
 
     T &operator[](size_t index)
@@ -87,9 +87,9 @@ public:
 
     void grow()
     {
-        if (_count < _capacity)
+        if (_count == _capacity)
         {
-            size_t new_capacity = _capacity + _capacity / 4;
+            size_t new_capacity = _capacity + _capacity / 4 + 1;
             T *new_storage = new T[new_capacity];
 
             for (size_t i = 0; i < _count; i++)
@@ -97,7 +97,7 @@ public:
                 new_storage[i] = move(_storage[i]);
             }
 
-            delete _storage;
+            delete[] _storage;
             _storage = new_storage;
             _capacity = new_capacity;
         }
@@ -119,7 +119,7 @@ public:
                 new_storage[i] = move(_storage[i]);
             }
 
-            delete _storage;
+            delete[] _storage;
             _storage = new_storage;
             _capacity = new_capacity;
         }
@@ -129,7 +129,7 @@ public:
     {
         grow();
 
-        for (size_t j = _count; j > index; j--)
+        for (size_t j = _count - 1; j > index; j--)
         {
             _storage[j] = move(_storage[j - 1]);
         }
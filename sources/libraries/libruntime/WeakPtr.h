@@ -0,0 +1,109 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/RefCounted.h>
+#include <libruntime/RefPtr.h>
+
+namespace libruntime
+{
+
+// Point to a RefCounted object without keeping it alive, strong() gives a
+// RefPtr to it, or nullptr once it has been destroyed.
+template <typename T>
+class WeakPtr
+{
+private:
+    WeakLink<T> *_link;
+
+public:
+    WeakPtr() : _link(nullptr) {}
+    WeakPtr(nullptr_t) : _link(nullptr) {}
+
+    WeakPtr(RefPtr<T> &object) : _link(nullptr)
+    {
+        if (object)
+        {
+            _link = object->weak_link();
+            _link->ref();
+        }
+    }
+
+    WeakPtr(const WeakPtr &other) : _link(other._link)
+    {
+        if (_link)
+        {
+            _link->ref();
+        }
+    }
+
+    WeakPtr(WeakPtr &&other) : _link(other._link) { other._link = nullptr; }
+
+    ~WeakPtr()
+    {
+        if (_link)
+        {
+            _link->deref();
+        }
+    }
+
+    WeakPtr &operator=(const WeakPtr &other)
+    {
+        if (_link != other._link)
+        {
+            if (_link)
+            {
+                _link->deref();
+            }
+
+            _link = other._link;
+
+            if (_link)
+            {
+                _link->ref();
+            }
+        }
+
+        return *this;
+    }
+
+    WeakPtr &operator=(WeakPtr &&other)
+    {
+        if (this != &other)
+        {
+            if (_link)
+            {
+                _link->deref();
+            }
+
+            _link = other._link;
+            other._link = nullptr;
+        }
+
+        return *this;
+    }
+
+    bool operator==(const WeakPtr &other) const { return _link == other._link; }
+    bool operator!=(const WeakPtr &other) const { return _link != other._link; }
+
+    RefPtr<T> strong()
+    {
+        if (!_link)
+        {
+            return nullptr;
+        }
+
+        T *object = _link->try_ref();
+
+        if (!object)
+        {
+            return nullptr;
+        }
+
+        return adopt(*object);
+    }
+};
+
+} // namespace libruntime
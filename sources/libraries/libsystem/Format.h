@@ -105,6 +105,12 @@ libruntime::ErrorOr<size_t> format(Stream &stream, libruntime::RefPtr<T> &value,
     return format(stream, value.necked(), info);
 }
 
+template <typename T>
+libruntime::ErrorOr<size_t> format(Stream &stream, libruntime::RefPtrView<T> &value, FormatInfo &info)
+{
+    return format(stream, value.necked(), info);
+}
+
 template <typename T>
 libruntime::ErrorOr<size_t> format(Stream &stream, libruntime::OwnPtr<T> &value, FormatInfo &info)
 {
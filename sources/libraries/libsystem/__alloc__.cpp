@@ -2,610 +2,562 @@
 /* This code is licensed under the 3-Clause BSD License.                      */
 /* See: LICENSE.md                                                            */
 
-/*               Durand's Amazing Super Duper Memory functions.               */
+/*                     Size classes slab memory allocator.                    */
 
 #include <libc/string.h>
+#include <libruntime/Macros.h>
 #include <libsystem/Assert.h>
 #include <libsystem/Logger.h>
 #include <libsystem/__alloc__.h>
 #include <libsystem/__plugs__.h>
 
-#define VERSION "1.1"
-#define ALIGNMENT 16ul
+// Small objects are served from slabs holding objects of the same size class,
+// anything bigger than the last size class get its own run of pages.
+//
+// Slabs and large allocations are aligned on ALLOC_SLAB_SIZE, so the header
+// owning a pointer is always found by aligning the pointer down.
+//
+// In front of the slabs, each cpu keep two magazines of free objects for the
+// smallest size classes. Most alloc/free pairs are served from them with
+// interrupts disabled and without taking the memory lock.
 
-#define ALIGN_TYPE char
-#define ALIGN_INFO sizeof(ALIGN_TYPE) * 16
+#define ALLOC_ALIGNMENT 16ul
 
-#define ALIGN(ptr)                                       \
-    if (ALIGNMENT > 1)                                   \
-    {                                                    \
-        uintptr_t diff;                                  \
-        ptr = (void *)((uintptr_t)ptr + ALIGN_INFO);     \
-        diff = (uintptr_t)ptr & (ALIGNMENT - 1);         \
-        if (diff != 0)                                   \
-        {                                                \
-            diff = ALIGNMENT - diff;                     \
-            ptr = (void *)((uintptr_t)ptr + diff);       \
-        }                                                \
-        *((ALIGN_TYPE *)((uintptr_t)ptr - ALIGN_INFO)) = \
-            diff + ALIGN_INFO;                           \
-    }
+#define ALLOC_SLAB_SIZE (16 * 1024ul)
 
-#define UNALIGN(ptr)                                                     \
-    if (ALIGNMENT > 1)                                                   \
-    {                                                                    \
-        uintptr_t diff = *((ALIGN_TYPE *)((uintptr_t)ptr - ALIGN_INFO)); \
-        if (diff < (ALIGNMENT + ALIGN_INFO))                             \
-        {                                                                \
-            ptr = (void *)((uintptr_t)ptr - diff);                       \
-        }                                                                \
-    }
+#define ALLOC_SLAB_MAGIC 0x51ab51ab
+#define ALLOC_LARGE_MAGIC 0x1a26e1a2
+#define ALLOC_DEAD 0xdeaddead
 
-#define LIBALLOC_MAGIC 0xc001c0de
-#define LIBALLOC_DEAD 0xdeaddead
+#define ALLOC_SIZE_CLASS_COUNT 14
+#define ALLOC_SIZE_CLASS_MAX 2048
 
-struct AllocMinor;
+static const size_t _size_classes[ALLOC_SIZE_CLASS_COUNT] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048};
 
-struct AllocMajor
+#define ALLOC_CACHE_COUNT 8
+#define ALLOC_MAGAZINE_CLASS_COUNT 8 // From 16 up to 256 bytes.
+#define ALLOC_MAGAZINE_SIZE 16
+
+struct AllocMagazine
 {
-    unsigned int pages; ///< The number of pages in the block.
-    unsigned int size;  ///< The number of pages*pagesize in the block.
-    unsigned int usage; ///< The number of bytes used in the block.
-    AllocMajor *prev;   ///< Linked list information.
-    AllocMajor *next;   ///< Linked list information.
-    AllocMinor *first;  ///< A pointer to the first allocated memory in the block.
+    size_t count;
+    void *rounds[ALLOC_MAGAZINE_SIZE];
 };
 
-/** This is a structure found at the beginning of all
- * sections in a major block which were allocated by a
- * malloc, calloc, realloc call.
- */
-struct AllocMinor
+struct AllocCache
 {
-    unsigned int magic;    ///< A magic number to idenfity correctness.
-    unsigned int size;     ///< The size of the memory allocated. Could be 1 byte or more.
-    unsigned int req_size; ///< The size of memory requested.
-    AllocMinor *prev;      ///< Linked list information.
-    AllocMinor *next;      ///< Linked list information.
-    AllocMajor *block;     ///< The owning block. A pointer to the major structure.
+    AllocMagazine magazines[ALLOC_MAGAZINE_CLASS_COUNT][2];
+    size_t loaded[ALLOC_MAGAZINE_CLASS_COUNT]; ///< Which of the two magazines is the loaded one.
+
+    size_t hits;
+    size_t misses;
 };
 
-static AllocMajor *l_memRoot = nullptr; ///< The root memory block acquired from the system.
-static AllocMajor *l_bestBet = nullptr; ///< The major with the most free memory.
+static AllocCache _caches[ALLOC_CACHE_COUNT] = {};
+
+struct AllocFreeObject
+{
+    AllocFreeObject *next;
+};
 
-static unsigned int l_pageCount = 16;      ///< The number of pages to request per chunk. Set up in liballoc_init.
-static unsigned long long l_allocated = 0; ///< Running total of allocated memory.
-static unsigned long long l_inuse = 0;     ///< Running total of used memory.
+struct AllocSlab
+{
+    uint32_t magic;
+    uint32_t size_class;
+    uint32_t used;
+    uint32_t capacity;
+    AllocFreeObject *free_list;
+    AllocSlab *prev; ///< Linked list of the slabs with free objects.
+    AllocSlab *next; ///< Linked list of the slabs with free objects.
+};
 
-static long long l_warningCount = 0;     ///< Number of warnings encountered
-static long long l_errorCount = 0;       ///< Number of actual errors
-static long long l_possibleOverruns = 0; ///< Number of possible overruns
+#define ALLOC_SLAB_HEADER_SIZE __align_up(sizeof(AllocSlab), ALLOC_ALIGNMENT)
 
-#if defined DEBUG || defined INFO
-static void liballoc_dump()
+struct AllocLarge
 {
-#ifdef DEBUG
-    AllocMajor *maj = l_memRoot;
-    AllocMinor *min = nullptr;
-#endif
-
-    printf("liballoc: ------ Memory data ---------------\n");
-    printf("liballoc: System memory allocated: %i bytes\n", l_allocated);
-    printf("liballoc: Memory in used (malloc'ed): %i bytes\n", l_inuse);
-    printf("liballoc: Warning count: %i\n", l_warningCount);
-    printf("liballoc: Error count: %i\n", l_errorCount);
-    printf("liballoc: Possible overruns: %i\n", l_possibleOverruns);
-
-#ifdef DEBUG
-    while (maj != nullptr)
-    {
-        printf("liballoc: %x: total = %i, used = %i\n",
-               maj,
-               maj->size,
-               maj->usage);
-
-        min = maj->first;
-        while (min != nullptr)
-        {
-            printf("liballoc:    %x: %i bytes\n",
-                   min,
-                   min->size);
-            min = min->next;
-        }
+    uint32_t magic;
+    uint32_t pages;
+    size_t size;
+};
+
+static_assert(sizeof(AllocLarge) <= ALLOC_ALIGNMENT, "The large allocation header must fit before the first aligned byte.");
+
+// Slabs of each size class which still have free objects.
+static AllocSlab *_partial_slabs[ALLOC_SIZE_CLASS_COUNT] = {};
 
-        maj = maj->next;
+static int size_class_index(size_t size)
+{
+    if (size <= 64)
+    {
+        return size == 0 ? 0 : (size - 1) / 16;
     }
-#endif
 
-    FLUSH();
+    // Past 64 bytes there is two classes per power of two: 1.5 * 2^n and 2^(n+1).
+    int power = 31 - __builtin_clz(size - 1);
+    int upper_half = ((size - 1) >> (power - 1)) & 1;
+
+    return 4 + (power - 6) * 2 + upper_half;
 }
-#endif
 
-static AllocMajor *allocate_new_page(unsigned int size)
+static void *alloc_aligned_pages(size_t how_many_pages)
 {
-    unsigned int st;
-    AllocMajor *maj;
+    size_t page_size = __plugs__::get_page_size();
 
-    // This is how much space is required.
-    st = size + sizeof(AllocMajor);
-    st += sizeof(AllocMinor);
+    auto result = __plugs__::memory_alloc(how_many_pages);
 
-    // Perfect amount of space?
-    if ((st % __plugs__::get_page_size()) == 0)
-        st = st / (__plugs__::get_page_size());
-    else
-        st = st / (__plugs__::get_page_size()) + 1;
-    // No, add the buffer.
+    if (!result.succeed())
+    {
+        return nullptr;
+    }
 
-    // Make sure it's >= the minimum size.
-    if (st < l_pageCount)
-        st = l_pageCount;
+    if (result.value() % ALLOC_SLAB_SIZE == 0)
+    {
+        return reinterpret_cast<void *>(result.value());
+    }
+
+    // We were unlucky, ask for a bigger run and trim the unaligned ends.
+    __plugs__::memory_free(result.value(), how_many_pages);
 
-    auto result = __plugs__::memory_alloc(st);
+    size_t padding_pages = ALLOC_SLAB_SIZE / page_size - 1;
 
-    if (result.error() != libruntime::Error::SUCCEED)
+    result = __plugs__::memory_alloc(how_many_pages + padding_pages);
+
+    if (!result.succeed())
     {
-        l_warningCount += 1;
-        logger_warn("__plugs__::memory_alloc({}) return nullptr", st);
-        return nullptr; // uh oh, we ran out of memory.
+        return nullptr;
     }
-    else
+
+    uintptr_t aligned = __align_up(result.value(), ALLOC_SLAB_SIZE);
+
+    size_t head_pages = (aligned - result.value()) / page_size;
+    size_t tail_pages = padding_pages - head_pages;
+
+    if (head_pages)
     {
-        maj = (AllocMajor *)result.value();
+        __plugs__::memory_free(result.value(), head_pages);
     }
 
-    maj->prev = nullptr;
-    maj->next = nullptr;
-    maj->pages = st;
-    maj->size = st * __plugs__::get_page_size();
-    maj->usage = sizeof(AllocMajor);
-    maj->first = nullptr;
+    if (tail_pages)
+    {
+        __plugs__::memory_free(aligned + how_many_pages * page_size, tail_pages);
+    }
 
-    l_allocated += maj->size;
+    return reinterpret_cast<void *>(aligned);
+}
 
-#ifdef DEBUG
-    printf("liballoc: Resource allocated %x of %i pages (%i bytes) for %i size.\n", maj, st, maj->size, size);
+static void slab_link(AllocSlab *slab)
+{
+    AllocSlab *&head = _partial_slabs[slab->size_class];
 
-    printf("liballoc: Total memory usage = %i KB\n", (int)((l_allocated / (1024))));
-    FLUSH();
-#endif
+    slab->prev = nullptr;
+    slab->next = head;
 
-    return maj;
+    if (head)
+    {
+        head->prev = slab;
+    }
+
+    head = slab;
 }
 
-extern "C" void *__alloc__::malloc(size_t req_size)
+static void slab_unlink(AllocSlab *slab)
 {
-    int startedBet = 0;
-    unsigned long long bestSize = 0;
-    void *p = nullptr;
-    uintptr_t diff;
-    AllocMajor *maj;
-    AllocMinor *min;
-    AllocMinor *new_min;
-    unsigned long size = req_size;
+    if (slab->prev)
+    {
+        slab->prev->next = slab->next;
+    }
+    else
+    {
+        _partial_slabs[slab->size_class] = slab->next;
+    }
 
-    // For alignment, we adjust size so there's enough space to align.
-    if (ALIGNMENT > 1)
+    if (slab->next)
     {
-        size += ALIGNMENT + ALIGN_INFO;
+        slab->next->prev = slab->prev;
     }
 
-    // So, ideally, we really want an alignment of 0 or 1 in order
-    // to save space.
+    slab->prev = nullptr;
+    slab->next = nullptr;
+}
 
-    __plugs__::memory_lock();
+static AllocSlab *slab_create(int size_class)
+{
+    AllocSlab *slab = reinterpret_cast<AllocSlab *>(alloc_aligned_pages(ALLOC_SLAB_SIZE / __plugs__::get_page_size()));
 
-    if (size == 0)
+    if (slab == nullptr)
     {
-        l_warningCount += 1;
-        logger_warn("Alloc( 0 ) called from {#x}", __builtin_return_address(0));
+        return nullptr;
+    }
 
-        __plugs__::memory_unlock();
+    size_t object_size = _size_classes[size_class];
 
-        return malloc(1);
-    }
+    slab->magic = ALLOC_SLAB_MAGIC;
+    slab->size_class = size_class;
+    slab->used = 0;
+    slab->capacity = (ALLOC_SLAB_SIZE - ALLOC_SLAB_HEADER_SIZE) / object_size;
+    slab->free_list = nullptr;
+    slab->prev = nullptr;
+    slab->next = nullptr;
 
-    if (l_memRoot == nullptr)
+    // Thread the free list backward so objects are handed out in address order.
+    uintptr_t objects = reinterpret_cast<uintptr_t>(slab) + ALLOC_SLAB_HEADER_SIZE;
+
+    for (size_t i = slab->capacity; i > 0; i--)
     {
-        l_memRoot = allocate_new_page(size);
+        AllocFreeObject *object = reinterpret_cast<AllocFreeObject *>(objects + (i - 1) * object_size);
 
-        if (l_memRoot == nullptr)
-        {
-            __plugs__::memory_unlock();
-            logger_error("Initial memory block initialization failed", p);
-            assert_not_reached();
-        }
+        object->next = slab->free_list;
+        slab->free_list = object;
     }
 
-    // Now we need to bounce through every major and find enough space....
+    return slab;
+}
 
-    maj = l_memRoot;
-    startedBet = 0;
+static void *slab_alloc(int size_class)
+{
+    AllocSlab *slab = _partial_slabs[size_class];
 
-    // Start at the best bet....
-    if (l_bestBet != nullptr)
+    if (slab == nullptr)
     {
-        bestSize = l_bestBet->size - l_bestBet->usage;
+        slab = slab_create(size_class);
 
-        if (bestSize > (size + sizeof(AllocMinor)))
+        if (slab == nullptr)
         {
-            maj = l_bestBet;
-            startedBet = 1;
+            return nullptr;
         }
+
+        slab_link(slab);
     }
 
-    while (maj != nullptr)
+    AllocFreeObject *object = slab->free_list;
+
+    slab->free_list = object->next;
+    slab->used++;
+
+    if (slab->used == slab->capacity)
     {
-        diff = maj->size - maj->usage;
+        slab_unlink(slab);
+    }
 
-        if (bestSize < diff)
-        {
-            l_bestBet = maj;
-            bestSize = diff;
-        }
+    return object;
+}
 
-        // CASE 1:  There is not enough space in this major block.
-        if (diff < (size + sizeof(AllocMinor)))
-        {
-            if (maj->next != nullptr)
-            {
-                maj = maj->next;
-                continue;
-            }
+static void slab_free(AllocSlab *slab, void *ptr)
+{
+    if (slab->used == slab->capacity)
+    {
+        slab_link(slab);
+    }
 
-            if (startedBet == 1) // If we started at the best bet,
-            {                    // let's start all over again.
-                maj = l_memRoot;
-                startedBet = 0;
-                continue;
-            }
+    AllocFreeObject *object = reinterpret_cast<AllocFreeObject *>(ptr);
 
-            // Create a new major block next to this one and...
-            maj->next = allocate_new_page(size); // next one will be okay.
-            if (maj->next == nullptr)
-                break; // no more memory.
-            maj->next->prev = maj;
-            maj = maj->next;
+    object->next = slab->free_list;
+    slab->free_list = object;
+    slab->used--;
 
-            // .. fall through to CASE 2 ..
-        }
+    // Keep the last partial slab of a class around, so an object going back
+    // and forth doesn't create and destroy a slab each time.
+    if (slab->used == 0 && (slab->prev || slab->next))
+    {
+        slab_unlink(slab);
+        slab->magic = ALLOC_DEAD;
 
-        // CASE 2: It's a brand new block.
-        if (maj->first == nullptr)
-        {
-            maj->first = (AllocMinor *)((uintptr_t)maj + sizeof(AllocMajor));
+        __plugs__::memory_free(reinterpret_cast<uintptr_t>(slab), ALLOC_SLAB_SIZE / __plugs__::get_page_size());
+    }
+}
+
+static void *large_alloc(size_t size)
+{
+    size_t pages = __align_up(size + ALLOC_ALIGNMENT, __plugs__::get_page_size()) / __plugs__::get_page_size();
 
-            maj->first->magic = LIBALLOC_MAGIC;
-            maj->first->prev = nullptr;
-            maj->first->next = nullptr;
-            maj->first->block = maj;
-            maj->first->size = size;
-            maj->first->req_size = req_size;
-            maj->usage += size + sizeof(AllocMinor);
+    AllocLarge *large = reinterpret_cast<AllocLarge *>(alloc_aligned_pages(pages));
 
-            l_inuse += size;
+    if (large == nullptr)
+    {
+        return nullptr;
+    }
 
-            p = (void *)((uintptr_t)(maj->first) + sizeof(AllocMinor));
+    large->magic = ALLOC_LARGE_MAGIC;
+    large->pages = pages;
+    large->size = size;
 
-            ALIGN(p);
+    return reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(large) + ALLOC_ALIGNMENT);
+}
 
-            __plugs__::memory_unlock(); // release the lock
-            return p;
-        }
+static void large_free(AllocLarge *large)
+{
+    large->magic = ALLOC_DEAD;
 
-        // CASE 3: Block in use and enough space at the start of the block.
-        diff = (uintptr_t)(maj->first);
-        diff -= (uintptr_t)maj;
-        diff -= sizeof(AllocMajor);
+    __plugs__::memory_free(reinterpret_cast<uintptr_t>(large), large->pages);
+}
 
-        if (diff >= (size + sizeof(AllocMinor)))
-        {
-            // Yes, space in front. Squeeze in.
-            maj->first->prev = (AllocMinor *)((uintptr_t)maj + sizeof(AllocMajor));
-            maj->first->prev->next = maj->first;
-            maj->first = maj->first->prev;
+static AllocCache &current_cache()
+{
+    size_t cpu = __plugs__::current_cpu();
 
-            maj->first->magic = LIBALLOC_MAGIC;
-            maj->first->prev = nullptr;
-            maj->first->block = maj;
-            maj->first->size = size;
-            maj->first->req_size = req_size;
-            maj->usage += size + sizeof(AllocMinor);
+    assert(cpu < ALLOC_CACHE_COUNT);
 
-            l_inuse += size;
+    return _caches[cpu];
+}
 
-            p = (void *)((uintptr_t)(maj->first) + sizeof(AllocMinor));
-            ALIGN(p);
+static void *cache_alloc(int size_class)
+{
+    bool were_enabled = __plugs__::interrupts_disable();
 
-            __plugs__::memory_unlock(); // release the lock
-            return p;
-        }
+    AllocCache &cache = current_cache();
 
-        // CASE 4: There is enough space in this block. But is it contiguous?
-        min = maj->first;
+    AllocMagazine *loaded = &cache.magazines[size_class][cache.loaded[size_class]];
+    AllocMagazine *previous = &cache.magazines[size_class][!cache.loaded[size_class]];
 
-        // Looping within the block now...
-        while (min != nullptr)
+    if (loaded->count == 0)
+    {
+        if (previous->count == 0)
         {
-            // CASE 4.1: End of minors in a block. Space from last and end?
-            if (min->next == nullptr)
-            {
-                // the rest of this block is free...  is it big enough?
-                diff = (uintptr_t)(maj) + maj->size;
-                diff -= (uintptr_t)min;
-                diff -= sizeof(AllocMinor);
-                diff -= min->size;
-                // minus already existing usage..
-
-                if (diff >= (size + sizeof(AllocMinor)))
-                {
-                    // yay....
-                    min->next = (AllocMinor *)((uintptr_t)min + sizeof(AllocMinor) + min->size);
-                    min->next->prev = min;
-                    min = min->next;
-                    min->next = nullptr;
-                    min->magic = LIBALLOC_MAGIC;
-                    min->block = maj;
-                    min->size = size;
-                    min->req_size = req_size;
-                    maj->usage += size + sizeof(AllocMinor);
-
-                    l_inuse += size;
-
-                    p = (void *)((uintptr_t)min + sizeof(AllocMinor));
-                    ALIGN(p);
-
-                    __plugs__::memory_unlock(); // release the lock
-                    return p;
-                }
-            }
+            cache.misses++;
 
-            // CASE 4.2: Is there space between two minors?
-            if (min->next != nullptr)
+            __plugs__::memory_lock();
+
+            while (previous->count < ALLOC_MAGAZINE_SIZE)
             {
-                // is the difference between here and next big enough?
-                diff = (uintptr_t)(min->next);
-                diff -= (uintptr_t)min;
-                diff -= sizeof(AllocMinor);
-                diff -= min->size;
-                // minus our existing usage.
-
-                if (diff >= (size + sizeof(AllocMinor)))
+                void *ptr = slab_alloc(size_class);
+
+                if (ptr == nullptr)
                 {
-                    // yay......
-                    new_min = (AllocMinor *)((uintptr_t)min + sizeof(AllocMinor) + min->size);
-
-                    new_min->magic = LIBALLOC_MAGIC;
-                    new_min->next = min->next;
-                    new_min->prev = min;
-                    new_min->size = size;
-                    new_min->req_size = req_size;
-                    new_min->block = maj;
-                    min->next->prev = new_min;
-                    min->next = new_min;
-                    maj->usage += size + sizeof(AllocMinor);
-
-                    l_inuse += size;
-
-                    p = (void *)((uintptr_t)new_min + sizeof(AllocMinor));
-                    ALIGN(p);
-
-                    __plugs__::memory_unlock(); // release the lock
-                    return p;
+                    break;
                 }
-            } // min->next != nullptr
 
-            min = min->next;
-        } // while min != nullptr ...
-
-        // CASE 5: Block full! Ensure next block and loop.
-        if (maj->next == nullptr)
-        {
-            if (startedBet == 1)
-            {
-                maj = l_memRoot;
-                startedBet = 0;
-                continue;
+                previous->rounds[previous->count] = ptr;
+                previous->count++;
             }
 
-            // we've run out. we need more...
-            maj->next = allocate_new_page(size); // next one guaranteed to be okay
-            if (maj->next == nullptr)
-                break; //  uh oh,  no more memory.....
-            maj->next->prev = maj;
+            __plugs__::memory_unlock();
+        }
+        else
+        {
+            cache.hits++;
         }
 
-        maj = maj->next;
-    } // while (maj != nullptr)
+        cache.loaded[size_class] = !cache.loaded[size_class];
+        loaded = previous;
+    }
+    else
+    {
+        cache.hits++;
+    }
 
-    __plugs__::memory_unlock(); // release the lock
+    void *ptr = nullptr;
 
-    // Malloc should never return nullptr.
-    logger_fatal("Out of memory!");
-    assert_not_reached();
+    if (loaded->count > 0)
+    {
+        loaded->count--;
+        ptr = loaded->rounds[loaded->count];
+    }
+
+    __plugs__::interrupts_restore(were_enabled);
+
+    return ptr;
 }
 
-extern "C" void __alloc__::free(void *ptr)
+static void cache_free(AllocSlab *slab, void *ptr)
 {
-    AllocMinor *min;
-    AllocMajor *maj;
-
-    if (ptr == nullptr)
-    {
-        l_warningCount += 1;
-        logger_warn("free(nullptr) called from {x}", __builtin_return_address(0));
-        return;
-    }
+    int size_class = slab->size_class;
 
-    UNALIGN(ptr);
+    bool were_enabled = __plugs__::interrupts_disable();
 
-    __plugs__::memory_lock(); // lockit
+    AllocCache &cache = current_cache();
 
-    min = (AllocMinor *)((uintptr_t)ptr - sizeof(AllocMinor));
+    AllocMagazine *loaded = &cache.magazines[size_class][cache.loaded[size_class]];
+    AllocMagazine *previous = &cache.magazines[size_class][!cache.loaded[size_class]];
 
-    if (min->magic != LIBALLOC_MAGIC)
+    if (loaded->count == ALLOC_MAGAZINE_SIZE)
     {
-        l_errorCount += 1;
-
-        // Check for overrun errors. For all bytes of LIBALLOC_MAGIC
-        if (((min->magic & 0xFFFFFF) == (LIBALLOC_MAGIC & 0xFFFFFF)) ||
-            ((min->magic & 0xFFFF) == (LIBALLOC_MAGIC & 0xFFFF)) ||
-            ((min->magic & 0xFF) == (LIBALLOC_MAGIC & 0xFF)))
+        if (previous->count > 0)
         {
-            l_possibleOverruns += 1;
-            logger_error("Possible 1-3 byte overrun for magic {x} != {x}", min->magic, LIBALLOC_MAGIC);
-        }
+            cache.misses++;
 
-        if (min->magic == LIBALLOC_DEAD)
-        {
-            logger_error("Multiple free() attempt on {x} from {x}", ptr, __builtin_return_address(0));
+            __plugs__::memory_lock();
+
+            for (size_t i = 0; i < previous->count; i++)
+            {
+                void *round = previous->rounds[i];
+
+                slab_free(reinterpret_cast<AllocSlab *>(__align_down(reinterpret_cast<uintptr_t>(round), ALLOC_SLAB_SIZE)), round);
+            }
+
+            previous->count = 0;
+
+            __plugs__::memory_unlock();
         }
         else
         {
-            logger_error("Bad free({x}) called from {x}", ptr, __builtin_return_address(0));
+            cache.hits++;
         }
 
-        // being lied to...
-        __plugs__::memory_unlock(); // release the lock
-        return;
+        cache.loaded[size_class] = !cache.loaded[size_class];
+        loaded = previous;
+    }
+    else
+    {
+        cache.hits++;
     }
 
-    maj = min->block;
+    loaded->rounds[loaded->count] = ptr;
+    loaded->count++;
+
+    __plugs__::interrupts_restore(were_enabled);
+}
 
-    l_inuse -= min->size;
+// Return how many bytes can be used at ptr, or zero if we don't own ptr.
+static size_t usable_size(void *ptr)
+{
+    uintptr_t header = __align_down(reinterpret_cast<uintptr_t>(ptr), ALLOC_SLAB_SIZE);
+
+    if (reinterpret_cast<AllocSlab *>(header)->magic == ALLOC_SLAB_MAGIC)
+    {
+        return _size_classes[reinterpret_cast<AllocSlab *>(header)->size_class];
+    }
+    else if (reinterpret_cast<AllocLarge *>(header)->magic == ALLOC_LARGE_MAGIC)
+    {
+        return reinterpret_cast<AllocLarge *>(header)->size;
+    }
+    else
+    {
+        return 0;
+    }
+}
 
-    maj->usage -= (min->size + sizeof(AllocMinor));
-    min->magic = LIBALLOC_DEAD;
+extern "C" void *__alloc__::malloc(size_t size)
+{
+    void *ptr = nullptr;
 
-    if (min->next != nullptr)
-        min->next->prev = min->prev;
-    if (min->prev != nullptr)
-        min->prev->next = min->next;
+    if (size <= ALLOC_SIZE_CLASS_MAX && size_class_index(size) < ALLOC_MAGAZINE_CLASS_COUNT)
+    {
+        ptr = cache_alloc(size_class_index(size));
+    }
+    else
+    {
+        __plugs__::memory_lock();
 
-    if (min->prev == nullptr)
-        maj->first = min->next;
+        if (size <= ALLOC_SIZE_CLASS_MAX)
+        {
+            ptr = slab_alloc(size_class_index(size));
+        }
+        else
+        {
+            ptr = large_alloc(size);
+        }
 
-    // We need to clean up after the majors now....
+        __plugs__::memory_unlock();
+    }
 
-    if (maj->first == nullptr) // Block completely unused.
+    if (ptr == nullptr)
     {
-        if (l_memRoot == maj)
-            l_memRoot = maj->next;
+        // Malloc should never return nullptr.
+        logger_fatal("Out of memory!");
+        assert_not_reached();
+    }
 
-        if (l_bestBet == maj)
-            l_bestBet = nullptr;
+    return ptr;
+}
 
-        if (maj->prev != nullptr)
-            maj->prev->next = maj->next;
+extern "C" void __alloc__::free(void *ptr)
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+
+    uintptr_t header = __align_down(reinterpret_cast<uintptr_t>(ptr), ALLOC_SLAB_SIZE);
 
-        if (maj->next != nullptr)
-            maj->next->prev = maj->prev;
+    if (reinterpret_cast<AllocSlab *>(header)->magic == ALLOC_SLAB_MAGIC &&
+        reinterpret_cast<AllocSlab *>(header)->size_class < ALLOC_MAGAZINE_CLASS_COUNT)
+    {
+        cache_free(reinterpret_cast<AllocSlab *>(header), ptr);
+        return;
+    }
 
-        l_allocated -= maj->size;
+    __plugs__::memory_lock();
 
-        __plugs__::memory_free((uintptr_t)maj, maj->pages);
+    if (reinterpret_cast<AllocSlab *>(header)->magic == ALLOC_SLAB_MAGIC)
+    {
+        slab_free(reinterpret_cast<AllocSlab *>(header), ptr);
+    }
+    else if (reinterpret_cast<AllocLarge *>(header)->magic == ALLOC_LARGE_MAGIC)
+    {
+        large_free(reinterpret_cast<AllocLarge *>(header));
+    }
+    else if (reinterpret_cast<AllocSlab *>(header)->magic == ALLOC_DEAD)
+    {
+        logger_error("Multiple free() attempt on {x} from {x}", ptr, __builtin_return_address(0));
     }
     else
     {
-        if (l_bestBet != nullptr)
-        {
-            int bestSize = l_bestBet->size - l_bestBet->usage;
-            int majSize = maj->size - maj->usage;
-
-            if (majSize > bestSize)
-                l_bestBet = maj;
-        }
+        logger_error("Bad free({x}) called from {x}", ptr, __builtin_return_address(0));
     }
 
-    __plugs__::memory_unlock(); // release the lock
+    __plugs__::memory_unlock();
 }
 
 extern "C" void *__alloc__::calloc(size_t nobj, size_t size)
 {
-    int real_size;
-    void *p;
+    size_t real_size = nobj * size;
 
-    real_size = nobj * size;
+    assert(size == 0 || real_size / size == nobj);
 
-    p = malloc(real_size);
+    void *ptr = malloc(real_size);
 
-    libc::memset(p, 0, real_size);
+    libc::memset(ptr, 0, real_size);
 
-    return p;
+    return ptr;
 }
 
-extern "C" void *__alloc__::realloc(void *p, size_t size)
+extern "C" void *__alloc__::realloc(void *ptr, size_t size)
 {
-    void *ptr;
-    AllocMinor *min;
-    unsigned int real_size;
-
-    // Honour the case of size == 0 => free old and return nullptr
-    if (size == 0)
+    if (ptr == nullptr)
     {
-        free(p);
-        return nullptr;
+        return malloc(size);
     }
 
-    // In the case of a nullptr pointer, return a simple malloc.
-    if (p == nullptr)
+    if (size == 0)
     {
-        return malloc(size);
+        free(ptr);
+        return nullptr;
     }
 
-    // Unalign the pointer if required.
-    ptr = p;
-    UNALIGN(ptr);
+    __plugs__::memory_lock();
+    size_t old_size = usable_size(ptr);
+    __plugs__::memory_unlock();
 
-    __plugs__::memory_lock(); // lockit
+    assert(old_size != 0);
 
-    min = (AllocMinor *)((uintptr_t)ptr - sizeof(AllocMinor));
+    bool still_fit = old_size > ALLOC_SIZE_CLASS_MAX
+                         ? size > ALLOC_SIZE_CLASS_MAX && size <= old_size
+                         : size <= old_size && size_class_index(size) == size_class_index(old_size);
 
-    // Ensure it is a valid structure.
-    if (min->magic != LIBALLOC_MAGIC)
+    if (still_fit)
     {
-        l_errorCount += 1;
+        return ptr;
+    }
 
-        // FIXME: this code expecte the hoste to by little endian
-        // Check for overrun errors. For all bytes of LIBALLOC_MAGIC
-        if (((min->magic & 0xFFFFFF) == (LIBALLOC_MAGIC & 0xFFFFFF)) ||
-            ((min->magic & 0xFFFF) == (LIBALLOC_MAGIC & 0xFFFF)) ||
-            ((min->magic & 0xFF) == (LIBALLOC_MAGIC & 0xFF)))
-        {
-            l_possibleOverruns += 1;
-            logger_error("Possible 1-3 byte overrun for magic {x} != {x}", min->magic, LIBALLOC_MAGIC);
-        }
-        else if (min->magic == LIBALLOC_DEAD)
-        {
-            logger_error("Multiple free() attempt on {x} from {x}.", ptr, __builtin_return_address(0));
-        }
-        else
-        {
-            logger_error("Bad free( {x} ) called from {x}.", ptr, __builtin_return_address(0));
-        }
+    void *new_ptr = malloc(size);
 
-        __plugs__::memory_unlock();
+    libc::memcpy(new_ptr, ptr, size < old_size ? size : old_size);
 
-        return nullptr;
-    }
+    free(ptr);
 
-    // Definitely a memory block.
+    return new_ptr;
+}
 
-    real_size = min->req_size;
+__alloc__::AllocStats __alloc__::stats()
+{
+    AllocStats stats = {};
 
-    if (real_size >= size)
+    for (size_t i = 0; i < ALLOC_CACHE_COUNT; i++)
     {
-        min->req_size = size;
-        __plugs__::memory_unlock();
-        return p;
+        stats.magazine_hits += _caches[i].hits;
+        stats.magazine_misses += _caches[i].misses;
     }
 
-    __plugs__::memory_unlock();
-
-    // If we got here then we're reallocating to a block bigger than us.
-    ptr = malloc(size); // We need to allocate new memory
-    libc::memcpy(ptr, p, real_size);
-    free(p);
-
-    return ptr;
+    return stats;
 }
@@ -17,4 +17,12 @@ extern "C" void *calloc(size_t nobj, size_t size);
 
 extern "C" void *realloc(void *p, size_t size);
 
+struct AllocStats
+{
+    size_t magazine_hits;
+    size_t magazine_misses;
+};
+
+AllocStats stats();
+
 } // namespace __alloc__
@@ -8,6 +8,7 @@
 #include <libruntime/Types.h>
 #include <libsystem/FileStream.h>
 #include <libsystem/Stream.h>
+#include <libsystem/__plugs_processor__.h>
 
 extern "C" void __plug_init_libsystem();
 
@@ -30,6 +31,7 @@ libruntime::ErrorOr<size_t> file_tell(int handle);
 
 /* --- Memory Managment ----------------------------------------------------- */
 
+// Whether the memory lock is held by the caller, not by anyone.
 bool memory_is_lock();
 
 void memory_lock();
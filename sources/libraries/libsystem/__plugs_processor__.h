@@ -0,0 +1,26 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Types.h>
+
+// Split from __plugs__.h so locks can use them, the rest of the plugs need
+// streams, which need RefCounted, which need a lock.
+
+namespace __plugs__
+{
+
+/* --- Processor ------------------------------------------------------------ */
+
+// Stop the caller from being preempted, return true if it could have been.
+bool interrupts_disable();
+
+void interrupts_restore(bool were_enabled);
+
+// Index of the cpu (or of the thread in userspace) running the caller,
+// only meaningful while interrupts are disabled.
+size_t current_cpu();
+
+} // namespace __plugs__
@@ -2,12 +2,14 @@
 /* This code is licensed under the 3-Clause BSD License.                      */
 /* See: LICENSE.md                                                            */
 
+#include <libmath/Divide.h>
 #include <libsystem/Assert.h>
 #include <libsystem/Logger.h>
 #include <libsystem/Stdio.h>
 
 #include "arch/Arch.h"
 #include "system/System.h"
+#include "system/scheduling/Timer.h"
 
 using namespace libsystem;
 
@@ -26,7 +28,19 @@ void PANIC(const char *message)
 
 void tick()
 {
-    __atomic_add_fetch(&_current_tick, 1, __ATOMIC_SEQ_CST);
+    uint64_t now = arch::clock_ticks();
+    uint64_t current = get_tick();
+
+    // Several cpus may be catching up at the same time, each tick is
+    // expired by the one which moved the count to it.
+    while (current < now)
+    {
+        if (__atomic_compare_exchange_n(&_current_tick, &current, current + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+        {
+            current++;
+            scheduling::expire_timers(current);
+        }
+    }
 }
 
 uint64_t get_tick()
@@ -34,4 +48,14 @@ uint64_t get_tick()
     return __atomic_load_n(&_current_tick, __ATOMIC_SEQ_CST);
 }
 
+uint64_t cycles_to_microseconds(uint64_t cycles)
+{
+    return libmath::divide(cycles * (1000000 / TICK_FREQUENCY), arch::clock_cycles_per_tick());
+}
+
+uint64_t cycles_to_milliseconds(uint64_t cycles)
+{
+    return libmath::divide(cycles * (1000 / TICK_FREQUENCY), arch::clock_cycles_per_tick());
+}
+
 } // namespace system
\ No newline at end of file
@@ -9,8 +9,23 @@
 namespace system
 {
 
+#define MAX_CPU_COUNT 8
+
+// A tick is a millisecond, so sleeps are exact to the millisecond.
+#define TICK_FREQUENCY 1000
+
 void PANIC(const char *message) __noreturn;
+
+// Called by the clock interrupt of every cpu, bring the tick count up to date
+// with the clock and expire the timers of every tick in between. Ticks are
+// skipped while every cpu is idle.
 void tick();
+
 uint64_t get_tick();
 
+// Convert a count of arch::clock_cycles(), zero until the clock is calibrated.
+uint64_t cycles_to_microseconds(uint64_t cycles);
+
+uint64_t cycles_to_milliseconds(uint64_t cycles);
+
 } // namespace system
@@ -2,7 +2,7 @@
 /* This code is licensed under the 3-Clause BSD License.                      */
 /* See: LICENSE.md                                                            */
 
-#include <libruntime/SpinLock.h>
+#include <libruntime/McsLock.h>
 #include <libsystem/Logger.h>
 #include <libsystem/__plugs__.h>
 
@@ -68,21 +68,40 @@ size_t get_page_size()
     return arch::get_page_size();
 }
 
-libruntime::SpinLock _memory_lock;
+// The heap is taken from interrupt handlers too, so it's held with interrupts
+// disabled, which also mean one queue node per cpu is enough.
+static libruntime::McsLock _memory_lock;
+static libruntime::McsLock::Node _memory_lock_nodes[MAX_CPU_COUNT];
+static bool _memory_lock_were_enabled[MAX_CPU_COUNT];
+static bool _memory_lock_held[MAX_CPU_COUNT];
 
 bool memory_is_lock()
 {
-    return _memory_lock.is_acquired();
+    bool were_enabled = arch::disable_interrupts();
+    bool held = _memory_lock_held[arch::get_current_cpu()];
+    arch::restore_interrupts(were_enabled);
+
+    return held;
 }
 
 void memory_lock()
 {
-    _memory_lock.acquire();
+    bool were_enabled = arch::disable_interrupts();
+    int cpu = arch::get_current_cpu();
+
+    _memory_lock.acquire(_memory_lock_nodes[cpu]);
+    _memory_lock_were_enabled[cpu] = were_enabled;
+    _memory_lock_held[cpu] = true;
 }
 
 void memory_unlock()
 {
-    _memory_lock.release();
+    int cpu = arch::get_current_cpu();
+    bool were_enabled = _memory_lock_were_enabled[cpu];
+
+    _memory_lock_held[cpu] = false;
+    _memory_lock.release(_memory_lock_nodes[cpu]);
+    arch::restore_interrupts(were_enabled);
 }
 
 libruntime::ErrorOr<uintptr_t> memory_alloc(size_t how_many_pages)
@@ -92,7 +111,24 @@ libruntime::ErrorOr<uintptr_t> memory_alloc(size_t how_many_pages)
 
 void memory_free(uintptr_t addr, size_t how_many_pages)
 {
-    system::memory::free_region(system::memory::MemoryRegion::from_aligned_address(addr, how_many_pages));
+    system::memory::free_region(system::memory::MemoryRegion::from_page(addr / arch::get_page_size(), how_many_pages));
+}
+
+/* --- Processor ------------------------------------------------------------ */
+
+bool interrupts_disable()
+{
+    return arch::disable_interrupts();
+}
+
+void interrupts_restore(bool were_enabled)
+{
+    arch::restore_interrupts(were_enabled);
+}
+
+size_t current_cpu()
+{
+    return arch::get_current_cpu();
 }
 
 /* --- Assert --------------------------------------------------------------- */
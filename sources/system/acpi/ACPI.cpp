@@ -1,11 +1,49 @@
+#include <libc/string.h>
+#include <libsystem/Assert.h>
 #include <libsystem/Logger.h>
 
+#include "system/System.h"
+
 #include "system/acpi/ACPI.h"
 #include "system/acpi/Tables.h"
 
 namespace system::acpi
 {
 
+static uintptr_t _local_apic_address = 0;
+static size_t _processor_count = 0;
+static uint8_t _processor_apic_ids[MAX_CPU_COUNT];
+
+static void parse_madt(MADT *madt)
+{
+    _local_apic_address = madt->local_apic_address;
+
+    madt->foreach_entry([](MADTEntry *entry) {
+        if (entry->type != MADT_LOCAL_APIC)
+        {
+            return;
+        }
+
+        auto local_apic = reinterpret_cast<MADTLocalAPIC *>(entry);
+
+        if (!(local_apic->flags & MADT_LOCAL_APIC_ENABLED))
+        {
+            return;
+        }
+
+        if (_processor_count == MAX_CPU_COUNT)
+        {
+            logger_warn("Ignoring processor {}, only {} are supported.", local_apic->apic_id, MAX_CPU_COUNT);
+            return;
+        }
+
+        logger_info("Found processor {} with local APIC {}", local_apic->processor_id, local_apic->apic_id);
+
+        _processor_apic_ids[_processor_count] = local_apic->apic_id;
+        _processor_count++;
+    });
+}
+
 void initialize(void *rsdp_addr)
 {
     logger_info("Initializing ACPI sub-system...");
@@ -24,7 +62,29 @@ void initialize(void *rsdp_addr)
                     libruntime::String(current->Signature, 4),
                     libruntime::String(current->OEMID, 6),
                     libruntime::String(current->OEMTableID, 8));
+
+        if (libc::memcmp(current->Signature, "APIC", 4) == 0)
+        {
+            parse_madt(reinterpret_cast<MADT *>(current));
+        }
     }
 }
 
+size_t processor_count()
+{
+    return _processor_count;
+}
+
+uint8_t processor_apic_id(size_t index)
+{
+    assert(index < _processor_count);
+
+    return _processor_apic_ids[index];
+}
+
+uintptr_t local_apic_address()
+{
+    return _local_apic_address;
+}
+
 } // namespace system::acpi
@@ -1,8 +1,18 @@
 #pragma once
 
+#include <libruntime/Types.h>
+
 namespace system::acpi
 {
 
 void initialize(void *rsdp_ptr);
 
+// Processors found in the MADT, the one we are booting on included.
+size_t processor_count();
+
+uint8_t processor_apic_id(size_t index);
+
+// Physical address of the local APIC of every processor, zero without a MADT.
+uintptr_t local_apic_address();
+
 } // namespace system::acpi
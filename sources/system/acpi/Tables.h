@@ -44,4 +44,50 @@ struct __packed RSDT
     }
 };
 
+#define MADT_LOCAL_APIC 0
+#define MADT_LOCAL_APIC_ENABLED (1 << 0)
+
+struct __packed MADTEntry
+{
+    uint8_t type;
+    uint8_t length;
+};
+
+struct __packed MADTLocalAPIC
+{
+    MADTEntry header;
+    uint8_t processor_id;
+    uint8_t apic_id;
+    uint32_t flags;
+};
+
+struct __packed MADT
+{
+    SDTH header;
+    uint32_t local_apic_address;
+    uint32_t flags;
+    uint8_t entries[];
+
+    template <typename Callback>
+    void foreach_entry(Callback callback)
+    {
+        size_t offset = 0;
+        size_t size = header.Length - sizeof(MADT);
+
+        while (offset + sizeof(MADTEntry) <= size)
+        {
+            auto entry = reinterpret_cast<MADTEntry *>(&entries[offset]);
+
+            if (entry->length == 0)
+            {
+                break;
+            }
+
+            callback(entry);
+
+            offset += entry->length;
+        }
+    }
+};
+
 } // namespace system::acpi
@@ -0,0 +1,190 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libsystem/Assert.h>
+
+#include "arch/Arch.h"
+#include "system/memory/AddressSpace.h"
+
+namespace system::memory
+{
+
+// Page faults look up the mappings, so this lock can't be held by a thread
+// which could be preempted on the same cpu.
+void AddressSpace::lock(bool &were_enabled)
+{
+    were_enabled = arch::disable_interrupts();
+    _lock.acquire();
+}
+
+void AddressSpace::unlock(bool were_enabled)
+{
+    _lock.release();
+    arch::restore_interrupts(were_enabled);
+}
+
+libruntime::RefPtr<MemoryMapping> AddressSpace::mapping_overlaping(MemoryRegion region)
+{
+    libruntime::RefPtr<MemoryMapping> result;
+
+    _mappings.foreach ([&](auto mapping) {
+        if (mapping->virtual_region().is_overlaping_with(region))
+        {
+            result = mapping;
+
+            return libruntime::Iteration::STOP;
+        }
+
+        return libruntime::Iteration::CONTINUE;
+    });
+
+    return result;
+}
+
+libruntime::ErrorOr<uintptr_t> AddressSpace::find_free_region(size_t how_many_pages)
+{
+    // First fit, the candidate is moved past every mapping it hit until it
+    // doesn't hit anything anymore.
+    uintptr_t candidate = _mappable_region.base_page();
+
+    while (candidate + how_many_pages <= _mappable_region.end_page())
+    {
+        auto mapping = mapping_overlaping(MemoryRegion::from_page(candidate, how_many_pages));
+
+        if (!mapping)
+        {
+            return candidate * arch::get_page_size();
+        }
+
+        candidate = mapping->virtual_region().end_page();
+    }
+
+    return libruntime::Error::OUT_OF_MEMORY;
+}
+
+libruntime::RefPtr<MemoryMapping> AddressSpace::attach(libruntime::RefPtr<MemoryObject> object, MemoryRegion virtual_region)
+{
+    auto mapping = libruntime::make<MemoryMapping>(this, virtual_region, object);
+
+    object->attach(mapping.necked());
+    _mappings.push_back(mapping);
+
+    return mapping;
+}
+
+libruntime::ErrorOr<libruntime::RefPtr<MemoryMapping>> AddressSpace::map(libruntime::RefPtr<MemoryObject> object, uintptr_t address)
+{
+    assert(object != nullptr);
+
+    if (address % arch::get_page_size() != 0)
+    {
+        return libruntime::Error::BAD_ADDRESS;
+    }
+
+    auto virtual_region = MemoryRegion::from_aligned_address(address, object->size());
+
+    if (virtual_region.base_page() < _mappable_region.base_page() ||
+        virtual_region.end_page() > _mappable_region.end_page())
+    {
+        return libruntime::Error::BAD_ADDRESS;
+    }
+
+    bool were_enabled;
+    lock(were_enabled);
+
+    if (mapping_overlaping(virtual_region))
+    {
+        unlock(were_enabled);
+
+        return libruntime::Error::ALREADY_MAPPED;
+    }
+
+    // Nothing is mapped in the page tables yet, pages come in on the first fault.
+    auto mapping = attach(object, virtual_region);
+
+    unlock(were_enabled);
+
+    return mapping;
+}
+
+libruntime::ErrorOr<libruntime::RefPtr<MemoryMapping>> AddressSpace::map(libruntime::RefPtr<MemoryObject> object)
+{
+    assert(object != nullptr);
+
+    bool were_enabled;
+    lock(were_enabled);
+
+    auto address = find_free_region(object->page_count() + 1);
+
+    if (!address.succeed())
+    {
+        unlock(were_enabled);
+
+        return address.error();
+    }
+
+    auto virtual_region = MemoryRegion::from_aligned_address(address.value() + arch::get_page_size(), object->size());
+    auto mapping = attach(object, virtual_region);
+
+    unlock(were_enabled);
+
+    return mapping;
+}
+
+void AddressSpace::unmap(libruntime::RefPtr<MemoryMapping> mapping)
+{
+    assert(mapping != nullptr);
+
+    bool were_enabled;
+    lock(were_enabled);
+
+    mapping->object()->detach(mapping.necked());
+    _mappings.remove(mapping);
+
+    unlock(were_enabled);
+}
+
+void AddressSpace::unmap_all()
+{
+    bool were_enabled;
+    lock(were_enabled);
+
+    _mappings.foreach ([&](auto mapping) {
+        mapping->object()->detach(mapping.necked());
+
+        return libruntime::Iteration::CONTINUE;
+    });
+
+    _mappings.clear();
+
+    unlock(were_enabled);
+}
+
+libruntime::RefPtr<MemoryMapping> AddressSpace::mapping_at(uintptr_t address)
+{
+    bool were_enabled;
+    lock(were_enabled);
+
+    auto mapping = mapping_overlaping(MemoryRegion::from_page(address / arch::get_page_size(), 1));
+
+    unlock(were_enabled);
+
+    return mapping;
+}
+
+bool AddressSpace::handle_page_fault(uintptr_t address, bool write)
+{
+    auto mapping = mapping_at(address);
+
+    if (!mapping)
+    {
+        return false;
+    }
+
+    size_t index = (address - mapping->virtual_region().base_address()) / arch::get_page_size();
+
+    return mapping->object()->fault_in(mapping.necked(), index, write);
+}
+
+} // namespace system::memory
@@ -1,21 +1,70 @@
 #pragma once
 
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/ErrorOr.h>
 #include <libruntime/LinkedList.h>
 #include <libruntime/RefPtr.h>
+#include <libruntime/SpinLock.h>
 
+#include "system/memory/MemoryMapping.h"
 #include "system/memory/MemoryObject.h"
 
 namespace system::memory
 {
 
+// Locks are always taken in this order: address space, memory object, page tables.
 class AddressSpace
 {
 private:
-    libruntime::LinkedList<libruntime::RefPtr<MemoryObject>> _objects;
+    libruntime::SpinLock _lock;
+    MemoryRegion _mappable_region;
+    libruntime::LinkedList<libruntime::RefPtr<MemoryMapping>> _mappings;
+
+    void lock(bool &were_enabled);
+    void unlock(bool were_enabled);
+
+    libruntime::RefPtr<MemoryMapping> mapping_overlaping(MemoryRegion region);
+
+    libruntime::ErrorOr<uintptr_t> find_free_region(size_t how_many_pages);
+
+    libruntime::RefPtr<MemoryMapping> attach(libruntime::RefPtr<MemoryObject> object, MemoryRegion virtual_region);
+
+protected:
+    // Must be called by the arch before tearing down its page tables.
+    void unmap_all();
 
 public:
-    AddressSpace() {}
-    ~AddressSpace() {}
+    MemoryRegion mappable_region() { return _mappable_region; }
+
+    AddressSpace(MemoryRegion mappable_region) : _mappable_region(mappable_region) {}
+
+    virtual ~AddressSpace() {}
+
+    libruntime::ErrorOr<libruntime::RefPtr<MemoryMapping>> map(libruntime::RefPtr<MemoryObject> object, uintptr_t address);
+
+    // Place the object anywhere, with at least one unmapped page below it.
+    libruntime::ErrorOr<libruntime::RefPtr<MemoryMapping>> map(libruntime::RefPtr<MemoryObject> object);
+
+    void unmap(libruntime::RefPtr<MemoryMapping> mapping);
+
+    libruntime::RefPtr<MemoryMapping> mapping_at(uintptr_t address);
+
+    // Return false if the address is not covered by any mapping.
+    bool handle_page_fault(uintptr_t address, bool write);
+
+    // Implemented by the arch to update its page tables, they are safe to
+    // call from any context.
+    virtual void map_page(uintptr_t virtual_address, uintptr_t physical_address, bool writable) = 0;
+
+    virtual void unmap_page(uintptr_t virtual_address) = 0;
+
+    virtual void unmap_region(MemoryRegion virtual_region) = 0;
+
+    // Make this address space the one used by the current cpu.
+    virtual void switch_to() = 0;
 };
 
 } // namespace system::memory
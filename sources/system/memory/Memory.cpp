@@ -11,6 +11,7 @@
 #include "system/memory/Memory.h"
 #include "system/memory/MemoryRegion.h"
 #include "system/memory/MemoryRegionAllocator.h"
+#include "system/trace/Trace.h"
 
 using namespace system;
 using namespace libruntime;
@@ -20,14 +21,14 @@ namespace system::memory
 
 static bool _bootstraped = false;
 static MemoryRegion _boostrap;
-static MemoryRegionAllocator *_allocator;
+static MemoryRegionAllocator *_allocator = nullptr;
 
 bool is_bootstraped()
 {
     return _bootstraped;
 }
 
-MemoryRegion alloc_region(size_t how_many_pages)
+MemoryRegion try_alloc_region(size_t how_many_pages)
 {
     assert(how_many_pages > 0);
 
@@ -38,21 +39,28 @@ MemoryRegion alloc_region(size_t how_many_pages)
 
     MemoryRegion region = MemoryRegion::empty();
 
-    if (_boostrap.page_count() >= how_many_pages)
+    if (!_allocator)
     {
-        // Look like we have some space in the bootstrap :)
+        // The allocator itself is being created, serve it from the bootstrap.
         region = _boostrap.take(how_many_pages);
-
-        if (_boostrap.is_empty())
-        {
-            logger_info("The bootstrap is now empty.");
-        }
     }
     else
     {
         region = _allocator->alloc_region(how_many_pages);
     }
 
+    if (!region.is_empty())
+    {
+        trace::record(trace::TraceEvent::PAGE_ALLOC, region.base_address(), region.page_count());
+    }
+
+    return region;
+}
+
+MemoryRegion alloc_region(size_t how_many_pages)
+{
+    MemoryRegion region = try_alloc_region(how_many_pages);
+
     if (region.is_empty())
     {
         PANIC("Out of memory!");
@@ -62,6 +70,41 @@ MemoryRegion alloc_region(size_t how_many_pages)
 }
 
 void free_region(MemoryRegion region)
+{
+    if (!_allocator)
+    {
+        // Still bootstraping, the region stays in the part of the bootstrap
+        // which is going to be reserved.
+        return;
+    }
+
+    trace::record(trace::TraceEvent::PAGE_FREE, region.base_address(), region.page_count());
+
+    _allocator->free_region(region);
+}
+
+static void bootstrap(MemoryRegion region)
+{
+    logger_info("Bootstraping with {}", region);
+
+    _boostrap = region;
+    _bootstraped = true;
+
+    auto allocator = new MemoryRegionAllocator();
+
+    MemoryRegion leftover = _boostrap;
+    _boostrap = MemoryRegion::empty();
+    _allocator = allocator;
+
+    // Everything the bootstrap handed out is now owned by the allocator and
+    // can be freed like any other region, what's left is plain free memory.
+    allocator->reserve_region(MemoryRegion::from_page(region.base_page(), region.page_count() - leftover.page_count()));
+    allocator->add_region(leftover);
+
+    logger_info("The bootstrap is now empty.");
+}
+
+void add_region(MemoryRegion region)
 {
     auto kernel_region = arch::get_kernel_region();
 
@@ -72,7 +115,7 @@ void free_region(MemoryRegion region)
 
         if (!lower_half.is_empty())
         {
-            free_region(lower_half);
+            add_region(lower_half);
         }
 
         // An another half of the region is over the kernel.
@@ -80,22 +123,61 @@ void free_region(MemoryRegion region)
 
         if (!upper_half.is_empty())
         {
-            free_region(lower_half);
+            add_region(upper_half);
         }
+
+        return;
     }
-    else if (!_bootstraped)
+
+    auto direct_map = arch::get_direct_map_region();
+
+    if (region.base_page() >= direct_map.end_page())
     {
-        logger_info("Bootstraping with {}", region);
+        logger_warn("{} is out of reach of the kernel, skipping...", region);
+        return;
+    }
+
+    if (region.end_page() > direct_map.end_page())
+    {
+        logger_warn("Only the memory under {} is usable, clipping {}...", direct_map.end_address(), region);
+        region = MemoryRegion::from_page(region.base_page(), direct_map.end_page() - region.base_page());
+    }
+
+    auto reserved = arch::get_reserved_low_region();
+
+    if (region.base_page() < reserved.end_page())
+    {
+        if (region.end_page() <= reserved.end_page())
+        {
+            return;
+        }
 
-        _boostrap = region;
-        _bootstraped = true;
+        region.take(reserved.end_page() - region.base_page());
+    }
 
-        _allocator = new MemoryRegionAllocator();
+    if (!_bootstraped)
+    {
+        bootstrap(region);
     }
     else
     {
-        _allocator->free_region(region);
+        _allocator->add_region(region);
     }
 }
 
+size_t used()
+{
+    return _allocator ? _allocator->used() : 0;
+}
+
+size_t free()
+{
+    return _allocator ? _allocator->free() : 0;
+}
+
+size_t total()
+{
+    return _allocator ? _allocator->total() : 0;
+}
+
 } // namespace system::memory
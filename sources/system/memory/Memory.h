@@ -14,8 +14,22 @@ namespace system::memory
 
 MemoryRegion alloc_region(size_t how_many_pages);
 
+// Like alloc_region(), but return an empty region instead of panicking when
+// physical memory runs out.
+MemoryRegion try_alloc_region(size_t how_many_pages);
+
 void free_region(MemoryRegion region);
 
+// Hand a region of usable physical memory to the kernel, the first one is
+// used to bootstrap the allocator.
+void add_region(MemoryRegion region);
+
+size_t used();
+
+size_t free();
+
+size_t total();
+
 bool is_bootstraped();
 
-} // namespace system::memory
\ No newline at end of file
+} // namespace system::memory
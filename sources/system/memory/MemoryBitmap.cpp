@@ -0,0 +1,74 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libc/string.h>
+#include <libsystem/Assert.h>
+
+#include "system/memory/MemoryBitmap.h"
+
+namespace system::memory
+{
+
+MemoryBitmap::MemoryBitmap(uint32_t *words, size_t page_count)
+    : _words(words), _page_count(page_count)
+{
+    libc::memset(_words, 0, MEMORY_BITMAP_SIZE(page_count));
+}
+
+bool MemoryBitmap::is_used(uintptr_t page)
+{
+    assert(page < _page_count);
+
+    return __atomic_load_n(&_words[page / 32], __ATOMIC_RELAXED) & (1u << (page % 32));
+}
+
+static uint32_t word_mask(uintptr_t word, uintptr_t base_page, uintptr_t end_page)
+{
+    uintptr_t first = word * 32 < base_page ? base_page - word * 32 : 0;
+    uintptr_t last = (word + 1) * 32 > end_page ? end_page - word * 32 : 32;
+
+    uint32_t mask = last == 32 ? 0xffffffff : (1u << last) - 1;
+
+    return mask & ~((1u << first) - 1);
+}
+
+bool MemoryBitmap::mark_used(MemoryRegion region)
+{
+    assert(region.end_page() <= _page_count);
+
+    bool succeed = true;
+
+    for (uintptr_t word = region.base_page() / 32; word * 32 < region.end_page(); word++)
+    {
+        uint32_t mask = word_mask(word, region.base_page(), region.end_page());
+
+        if (__atomic_fetch_or(&_words[word], mask, __ATOMIC_ACQ_REL) & mask)
+        {
+            succeed = false;
+        }
+    }
+
+    return succeed;
+}
+
+bool MemoryBitmap::mark_free(MemoryRegion region)
+{
+    assert(region.end_page() <= _page_count);
+
+    bool succeed = true;
+
+    for (uintptr_t word = region.base_page() / 32; word * 32 < region.end_page(); word++)
+    {
+        uint32_t mask = word_mask(word, region.base_page(), region.end_page());
+
+        if ((__atomic_fetch_and(&_words[word], ~mask, __ATOMIC_ACQ_REL) & mask) != mask)
+        {
+            succeed = false;
+        }
+    }
+
+    return succeed;
+}
+
+} // namespace system::memory
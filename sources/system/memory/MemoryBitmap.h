@@ -0,0 +1,41 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Types.h>
+
+#include "system/memory/MemoryRegion.h"
+
+namespace system::memory
+{
+
+// Size in bytes of the bitmap needed to track __page_count pages.
+#define MEMORY_BITMAP_SIZE(__page_count) (((__page_count) + 31) / 32 * 4)
+
+// One bit per physical page, set while the page is in use.
+// Bits are updated atomically so cpus can mark their pages without locking.
+class MemoryBitmap
+{
+private:
+    uint32_t *_words;
+    size_t _page_count;
+
+public:
+    size_t page_count() { return _page_count; }
+
+    MemoryBitmap(uint32_t *words, size_t page_count);
+
+    ~MemoryBitmap() {}
+
+    bool is_used(uintptr_t page);
+
+    // Return false if one of the pages was already in use.
+    bool mark_used(MemoryRegion region);
+
+    // Return false if one of the pages wasn't in use.
+    bool mark_free(MemoryRegion region);
+};
+
+} // namespace system::memory
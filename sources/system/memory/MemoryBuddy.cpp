@@ -0,0 +1,197 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libc/string.h>
+#include <libmath/MinMax.h>
+#include <libsystem/Assert.h>
+
+#include "arch/Arch.h"
+#include "system/memory/MemoryBuddy.h"
+
+namespace system::memory
+{
+
+MemoryBuddy::MemoryBuddy(MemoryRegion span, uint8_t *bitmap)
+    : _span(span), _quantity(0), _bitmap(bitmap)
+{
+    size_t offset = 0;
+
+    for (int order = 0; order < MEMORY_BUDDY_ORDER_COUNT; order++)
+    {
+        _bitmap_offset[order] = offset;
+        offset += (span.page_count() >> (order + 1)) + 1;
+
+        _free_lists[order] = nullptr;
+    }
+
+    // Every page start as used, so every pair bit start cleared.
+    libc::memset(_bitmap, 0, MEMORY_BUDDY_BITMAP_SIZE(span.page_count()));
+}
+
+uintptr_t MemoryBuddy::block_index(uintptr_t page, int order)
+{
+    return (page - _span.base_page()) >> order;
+}
+
+bool MemoryBuddy::toggle_pair(uintptr_t page, int order)
+{
+    size_t bit = _bitmap_offset[order] + (block_index(page, order) >> 1);
+
+    _bitmap[bit / 8] ^= 1 << (bit % 8);
+
+    return _bitmap[bit / 8] & (1 << (bit % 8));
+}
+
+void MemoryBuddy::link_block(uintptr_t page, int order)
+{
+    FreeBlock *block = reinterpret_cast<FreeBlock *>(page * arch::get_page_size());
+
+    block->prev = nullptr;
+    block->next = _free_lists[order];
+
+    if (_free_lists[order])
+    {
+        _free_lists[order]->prev = block;
+    }
+
+    _free_lists[order] = block;
+}
+
+void MemoryBuddy::unlink_block(uintptr_t page, int order)
+{
+    FreeBlock *block = reinterpret_cast<FreeBlock *>(page * arch::get_page_size());
+
+    if (block->prev)
+    {
+        block->prev->next = block->next;
+    }
+    else
+    {
+        _free_lists[order] = block->next;
+    }
+
+    if (block->next)
+    {
+        block->next->prev = block->prev;
+    }
+}
+
+void MemoryBuddy::free_block(uintptr_t page, int order)
+{
+    _quantity += 1ul << order;
+
+    while (order < MEMORY_BUDDY_ORDER_COUNT - 1)
+    {
+        // The pair bit is now set if our buddy is still in use.
+        if (toggle_pair(page, order))
+        {
+            break;
+        }
+
+        uintptr_t buddy = _span.base_page() + ((block_index(page, order) ^ 1) << order);
+
+        unlink_block(buddy, order);
+
+        page = libmath::min(page, buddy);
+        order++;
+    }
+
+    link_block(page, order);
+}
+
+void MemoryBuddy::free_pages(uintptr_t page, size_t count)
+{
+    while (count > 0)
+    {
+        // The page at address zero can't be told apart from nullptr in the
+        // free lists, and it's holding the real mode IVT anyway.
+        if (page == 0)
+        {
+            page++;
+            count--;
+
+            continue;
+        }
+
+        // Take the biggest aligned block that fit in what's left.
+        int order = 0;
+
+        while (order + 1 < MEMORY_BUDDY_ORDER_COUNT &&
+               (1ul << (order + 1)) <= count &&
+               ((page - _span.base_page()) & ((1ul << (order + 1)) - 1)) == 0)
+        {
+            order++;
+        }
+
+        free_block(page, order);
+
+        page += 1ul << order;
+        count -= 1ul << order;
+    }
+}
+
+MemoryRegion MemoryBuddy::take(size_t how_many_pages)
+{
+    if (how_many_pages == 0 || how_many_pages > _quantity)
+    {
+        return MemoryRegion::empty();
+    }
+
+    int order = 0;
+
+    while ((1ul << order) < how_many_pages)
+    {
+        order++;
+    }
+
+    int current_order = order;
+
+    while (current_order < MEMORY_BUDDY_ORDER_COUNT && !_free_lists[current_order])
+    {
+        current_order++;
+    }
+
+    if (current_order >= MEMORY_BUDDY_ORDER_COUNT)
+    {
+        return MemoryRegion::empty();
+    }
+
+    uintptr_t page = reinterpret_cast<uintptr_t>(_free_lists[current_order]) / arch::get_page_size();
+
+    unlink_block(page, current_order);
+
+    if (current_order < MEMORY_BUDDY_ORDER_COUNT - 1)
+    {
+        toggle_pair(page, current_order);
+    }
+
+    _quantity -= 1ul << current_order;
+
+    // Split the block until it is just big enough, giving back the upper halfs.
+    while (current_order > order)
+    {
+        current_order--;
+        free_block(page + (1ul << current_order), current_order);
+    }
+
+    // And give back the tail we don't need.
+    free_pages(page + how_many_pages, (1ul << order) - how_many_pages);
+
+    return MemoryRegion::from_page(page, how_many_pages);
+}
+
+void MemoryBuddy::put(MemoryRegion region)
+{
+    if (region.is_empty() || !region.is_overlaping_with(_span))
+    {
+        return;
+    }
+
+    uintptr_t base_page = libmath::max(region.base_page(), _span.base_page());
+    uintptr_t end_page = libmath::min(region.end_page(), _span.end_page());
+
+    free_pages(base_page, end_page - base_page);
+}
+
+} // namespace system::memory
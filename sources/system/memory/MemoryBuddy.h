@@ -0,0 +1,70 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Types.h>
+
+#include "system/memory/MemoryRegion.h"
+
+namespace system::memory
+{
+
+// Blocks go from one page (order 0) up to 2^15 pages (128MiB with 4KiB pages).
+#define MEMORY_BUDDY_ORDER_COUNT 16
+
+// Size in bytes of the bitmap needed to track a span of __page_count pages.
+#define MEMORY_BUDDY_BITMAP_SIZE(__page_count) \
+    (((__page_count) + MEMORY_BUDDY_ORDER_COUNT) / 8 + 1)
+
+// Binary buddy allocator over a span of physical pages.
+//
+// Free blocks are linked together through their first bytes, so every free
+// page must be accessible at its physical address. Each pair of buddies owns
+// one bit in the bitmap which is set when exactly one of the two is free,
+// that's all we need to know if a block can be coalesced with its buddy.
+class MemoryBuddy
+{
+private:
+    struct FreeBlock
+    {
+        FreeBlock *prev;
+        FreeBlock *next;
+    };
+
+    MemoryRegion _span;
+    size_t _quantity;
+
+    uint8_t *_bitmap;
+    size_t _bitmap_offset[MEMORY_BUDDY_ORDER_COUNT];
+
+    FreeBlock *_free_lists[MEMORY_BUDDY_ORDER_COUNT];
+
+    uintptr_t block_index(uintptr_t page, int order);
+
+    bool toggle_pair(uintptr_t page, int order);
+
+    void link_block(uintptr_t page, int order);
+
+    void unlink_block(uintptr_t page, int order);
+
+    void free_block(uintptr_t page, int order);
+
+    void free_pages(uintptr_t page, size_t count);
+
+public:
+    size_t quantity() { return _quantity; }
+
+    // The bitmap must be at least MEMORY_BUDDY_BITMAP_SIZE(span.page_count())
+    // bytes long and is owned by the caller.
+    MemoryBuddy(MemoryRegion span, uint8_t *bitmap);
+
+    ~MemoryBuddy() {}
+
+    MemoryRegion take(size_t how_many_pages);
+
+    void put(MemoryRegion region);
+};
+
+} // namespace system::memory
@@ -1,19 +1,34 @@
 #pragma once
 
-#include "system/memory/MemoryObject.h"
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/RefCounted.h>
 #include <libruntime/RefPtr.h>
 
+#include "system/memory/MemoryObject.h"
+
 namespace system::memory
 {
 
-class MemoryMapping
+class AddressSpace;
+
+class MemoryMapping : public libruntime::RefCounted<MemoryMapping>
 {
 private:
+    AddressSpace *_address_space;
     MemoryRegion _virtual_region;
     libruntime::RefPtr<MemoryObject> _object;
 
 public:
-    MemoryMapping(MemoryRegion virtual_region, MemoryObject object) {}
+    AddressSpace *address_space() { return _address_space; }
+    MemoryRegion virtual_region() { return _virtual_region; }
+    libruntime::RefPtr<MemoryObject> object() { return _object; }
+
+    MemoryMapping(AddressSpace *address_space, MemoryRegion virtual_region, libruntime::RefPtr<MemoryObject> object)
+        : _address_space(address_space), _virtual_region(virtual_region), _object(object) {}
+
     ~MemoryMapping() {}
 };
 
@@ -2,20 +2,170 @@
 /* This code is licensed under the 3-Clause BSD License.                      */
 /* See: LICENSE.md                                                            */
 
+#include <libsystem/Assert.h>
+
+#include "arch/Arch.h"
+#include "system/memory/AddressSpace.h"
+#include "system/memory/MemoryMapping.h"
 #include "system/memory/MemoryObject.h"
-#include "system/memory/Memory.h"
 
 namespace system::memory
 {
 
 static volatile int _memory_object_id_counter = 0;
 
-MemoryObject::MemoryObject(MemoryRegion region) : _id(__sync_add_and_fetch(&_memory_object_id_counter, 1)),
-                                                  _region(region) {}
+MemoryObject::MemoryObject(size_t page_count)
+    : _id(__sync_add_and_fetch(&_memory_object_id_counter, 1)),
+      _page_count(page_count),
+      _pages(new libruntime::RefPtr<MemoryPage>[page_count])
+{
+}
 
 MemoryObject::~MemoryObject()
 {
-    free_region(_region);
+    assert(_mappings.empty());
+
+    delete[] _pages;
+}
+
+size_t MemoryObject::size()
+{
+    return _page_count * arch::get_page_size();
+}
+
+// Page faults take this lock, so it can't be held by a thread which could be
+// preempted on the same cpu.
+void MemoryObject::lock(bool &were_enabled)
+{
+    were_enabled = arch::disable_interrupts();
+    _lock.acquire();
+}
+
+void MemoryObject::unlock(bool were_enabled)
+{
+    _lock.release();
+    arch::restore_interrupts(were_enabled);
+}
+
+void MemoryObject::invalidate(size_t index)
+{
+    _mappings.foreach ([&](MemoryMapping *mapping) {
+        mapping->address_space()->unmap_page(mapping->virtual_region().base_address() + index * arch::get_page_size());
+
+        return libruntime::Iteration::CONTINUE;
+    });
+}
+
+void MemoryObject::attach(MemoryMapping *mapping)
+{
+    bool were_enabled;
+    lock(were_enabled);
+
+    _mappings.push_back(mapping);
+
+    unlock(were_enabled);
+}
+
+void MemoryObject::detach(MemoryMapping *mapping)
+{
+    bool were_enabled;
+    lock(were_enabled);
+
+    _mappings.remove(mapping);
+    mapping->address_space()->unmap_region(mapping->virtual_region());
+
+    unlock(were_enabled);
+}
+
+libruntime::RefPtr<MemoryObject> MemoryObject::clone()
+{
+    auto clone = libruntime::make<MemoryObject>(_page_count);
+
+    bool were_enabled;
+    lock(were_enabled);
+
+    for (size_t i = 0; i < _page_count; i++)
+    {
+        if (_pages[i])
+        {
+            clone->_pages[i] = _pages[i];
+        }
+    }
+
+    // Our mappings may still be writable, they will fault again and get the
+    // pages back read-only.
+    _mappings.foreach ([&](MemoryMapping *mapping) {
+        mapping->address_space()->unmap_region(mapping->virtual_region());
+
+        return libruntime::Iteration::CONTINUE;
+    });
+
+    unlock(were_enabled);
+
+    // Until then, an other cpu could write through a stale entry to a page
+    // which is now shared with the clone.
+    arch::wait_unmapped_regions();
+
+    return clone;
+}
+
+bool MemoryObject::fault_in(MemoryMapping *mapping, size_t index, bool write)
+{
+    assert(index < _page_count);
+
+    bool were_enabled;
+    lock(were_enabled);
+
+    // The mapping was unmapped while we were looking it up.
+    if (!_mappings.containe(mapping))
+    {
+        unlock(were_enabled);
+
+        return false;
+    }
+
+    auto &page = _pages[index];
+
+    if (!page)
+    {
+        page = MemoryPage::create_zeroed();
+    }
+    else if (write && page->refcount() > 1)
+    {
+        page = page->copy();
+
+        // Other mappings of this object may still point to the shared page.
+        invalidate(index);
+    }
+
+    mapping->address_space()->map_page(
+        mapping->virtual_region().base_address() + index * arch::get_page_size(),
+        page->address(),
+        page->refcount() == 1);
+
+    unlock(were_enabled);
+
+    return true;
+}
+
+size_t MemoryObject::committed()
+{
+    size_t committed = 0;
+
+    bool were_enabled;
+    lock(were_enabled);
+
+    for (size_t i = 0; i < _page_count; i++)
+    {
+        if (_pages[i])
+        {
+            committed++;
+        }
+    }
+
+    unlock(were_enabled);
+
+    return committed;
 }
 
 } // namespace system::memory
@@ -4,26 +4,57 @@
 /* This code is licensed under the 3-Clause BSD License.                      */
 /* See: LICENSE.md                                                            */
 
+#include <libruntime/LinkedList.h>
 #include <libruntime/RefCounted.h>
+#include <libruntime/RefPtr.h>
+#include <libruntime/SpinLock.h>
 #include <libruntime/Types.h>
 
+#include "system/memory/MemoryPage.h"
 #include "system/memory/MemoryRegion.h"
 
 namespace system::memory
 {
 
+class MemoryMapping;
+
+// Pages are only committed when they are first touched through a mapping,
+// and pages shared by clones are copied before the first write to them.
 class MemoryObject : public libruntime::RefCounted<MemoryObject>
 {
 private:
     int _id;
-    MemoryRegion _region;
+    size_t _page_count;
+    libruntime::RefPtr<MemoryPage> *_pages;
+
+    libruntime::SpinLock _lock;
+    libruntime::LinkedList<MemoryMapping *> _mappings;
+
+    void lock(bool &were_enabled);
+    void unlock(bool were_enabled);
+
+    void invalidate(size_t index);
 
 public:
     int id() { return _id; }
-    MemoryRegion region() { return _region; }
+    size_t page_count() { return _page_count; }
+    size_t size();
 
-    MemoryObject(MemoryRegion region);
+    MemoryObject(size_t page_count);
     ~MemoryObject();
+
+    // Called by the address space when a mapping is created or destroyed.
+    void attach(MemoryMapping *mapping);
+    void detach(MemoryMapping *mapping);
+
+    // The clone share every committed page with this object. Must be called
+    // without any lock held, it waits for the other cpus to flush their TLB.
+    libruntime::RefPtr<MemoryObject> clone();
+
+    // Commit, or copy, the page at index and make it present in the mapping.
+    bool fault_in(MemoryMapping *mapping, size_t index, bool write);
+
+    size_t committed();
 };
 
 } // namespace system::memory
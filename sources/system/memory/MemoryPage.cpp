@@ -0,0 +1,40 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libc/string.h>
+
+#include "arch/Arch.h"
+#include "system/memory/Memory.h"
+#include "system/memory/MemoryPage.h"
+
+namespace system::memory
+{
+
+MemoryPage::~MemoryPage()
+{
+    // Other cpus may still have the page in their TLB.
+    arch::free_unmapped_region(_region);
+}
+
+libruntime::RefPtr<MemoryPage> MemoryPage::create_zeroed()
+{
+    auto region = alloc_region(1);
+
+    libc::memset(reinterpret_cast<void *>(region.base_address()), 0, arch::get_page_size());
+
+    return libruntime::make<MemoryPage>(region);
+}
+
+libruntime::RefPtr<MemoryPage> MemoryPage::copy()
+{
+    auto region = alloc_region(1);
+
+    libc::memcpy(reinterpret_cast<void *>(region.base_address()),
+                 reinterpret_cast<void *>(address()),
+                 arch::get_page_size());
+
+    return libruntime::make<MemoryPage>(region);
+}
+
+} // namespace system::memory
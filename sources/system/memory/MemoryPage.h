@@ -0,0 +1,34 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Pool.h>
+#include <libruntime/RefCounted.h>
+#include <libruntime/RefPtr.h>
+
+#include "system/memory/MemoryRegion.h"
+
+namespace system::memory
+{
+
+// One physical page, shared by every MemoryObject holding a reference to it.
+class MemoryPage : public libruntime::RefCounted<MemoryPage>, public libruntime::Pooled<MemoryPage>
+{
+private:
+    MemoryRegion _region;
+
+public:
+    uintptr_t address() { return _region.base_address(); }
+
+    MemoryPage(MemoryRegion region) : _region(region) {}
+
+    ~MemoryPage();
+
+    static libruntime::RefPtr<MemoryPage> create_zeroed();
+
+    libruntime::RefPtr<MemoryPage> copy();
+};
+
+} // namespace system::memory
@@ -1,25 +1,55 @@
+#include "arch/Arch.h"
 #include "system/memory/MemoryPool.h"
 
 namespace system::memory
 {
 
+MemoryPool::FreeExtent *MemoryPool::extent_at(uintptr_t page)
+{
+    return reinterpret_cast<FreeExtent *>(page * arch::get_page_size());
+}
+
+uintptr_t MemoryPool::page_of(FreeExtent *extent)
+{
+    return reinterpret_cast<uintptr_t>(extent) / arch::get_page_size();
+}
+
+void MemoryPool::unlink(FreeExtent *previous, FreeExtent *extent)
+{
+    if (previous)
+    {
+        previous->next = extent->next;
+    }
+    else
+    {
+        _head = extent->next;
+    }
+}
+
 MemoryRegion MemoryPool::take(size_t how_many_pages)
 {
-    for (size_t i = 0; i < _regions.count(); i++)
+    FreeExtent *previous = nullptr;
+
+    for (FreeExtent *extent = _head; extent; extent = extent->next)
     {
-        if (_regions[i].page_count() >= how_many_pages)
+        if (extent->page_count >= how_many_pages)
         {
-            MemoryRegion region = _regions[i].take(how_many_pages);
+            // Taken from the end, the descriptor stays where it is.
+            extent->page_count -= how_many_pages;
+
+            MemoryRegion region = MemoryRegion::from_page(page_of(extent) + extent->page_count, how_many_pages);
 
-            if (_regions[i].is_empty())
+            if (extent->page_count == 0)
             {
-                _regions.remove(i);
+                unlink(previous, extent);
             }
 
             _quantity -= how_many_pages;
 
             return region;
         }
+
+        previous = extent;
     }
 
     return MemoryRegion::empty();
@@ -27,19 +57,29 @@ MemoryRegion MemoryPool::take(size_t how_many_pages)
 
 void MemoryPool::take(MemoryRegion region)
 {
-    for (size_t i = 0; i < _regions.count(); i++)
+    FreeExtent *previous = nullptr;
+    FreeExtent *extent = _head;
+
+    while (extent)
     {
-        MemoryRegion &current_region = _regions[i];
+        MemoryRegion current_region = MemoryRegion::from_page(page_of(extent), extent->page_count);
 
         if (current_region.is_overlaping_with(region))
         {
-            MemoryRegion lower_half = current_region.half_under(region);
-            MemoryRegion upper_half = current_region.half_over(region);
+            unlink(previous, extent);
+            _quantity -= current_region.page_count();
 
-            _regions.remove(current_region);
+            put(current_region.half_under(region));
+            put(current_region.half_over(region));
 
-            put(lower_half);
-            put(upper_half);
+            // The list changed under us, start over.
+            previous = nullptr;
+            extent = _head;
+        }
+        else
+        {
+            previous = extent;
+            extent = extent->next;
         }
     }
 }
@@ -49,36 +89,51 @@ void MemoryPool::put(MemoryRegion region)
     if (region.is_empty())
         return;
 
-    for (size_t i = 0; i < _regions.count(); i++)
-    {
-        MemoryRegion &current_region = _regions[i];
+    _quantity += region.page_count();
 
-        assert(!current_region.is_overlaping_with(region));
+    FreeExtent *previous = nullptr;
+    FreeExtent *next = _head;
 
-        if (!current_region.is_contiguous_with(region))
-        {
-            current_region.merge(region);
+    while (next && page_of(next) < region.base_page())
+    {
+        previous = next;
+        next = next->next;
+    }
 
-            if (i + 1 < _regions.count())
-            {
-                MemoryRegion &next_region = _regions[i + 1];
+    assert(!previous || page_of(previous) + previous->page_count <= region.base_page());
+    assert(!next || region.end_page() <= page_of(next));
 
-                if (current_region.is_contiguous_with(next_region))
-                {
-                    current_region.merge(next_region);
-                    _regions.remove(next_region);
-                }
-            }
+    if (previous && page_of(previous) + previous->page_count == region.base_page())
+    {
+        previous->page_count += region.page_count();
 
-            return;
+        if (next && region.end_page() == page_of(next))
+        {
+            previous->page_count += next->page_count;
+            previous->next = next->next;
         }
+
+        return;
     }
 
-    _regions.insert_sorted(region, [](auto &left, auto &right) -> bool {
-        return left.base_page() < right.base_page();
-    });
+    FreeExtent *extent = extent_at(region.base_page());
+    extent->page_count = region.page_count();
+    extent->next = next;
 
-    _quantity += region.page_count();
+    if (next && region.end_page() == page_of(next))
+    {
+        extent->page_count += next->page_count;
+        extent->next = next->next;
+    }
+
+    if (previous)
+    {
+        previous->next = extent;
+    }
+    else
+    {
+        _head = extent;
+    }
 }
 
 } // namespace system::memory
@@ -1,7 +1,5 @@
 #pragma once
 
-#include <libruntime/OwnPtr.h>
-#include <libruntime/Vector.h>
 #include <libsystem/Assert.h>
 
 #include "system/memory/MemoryRegion.h"
@@ -9,16 +7,35 @@
 namespace system::memory
 {
 
+// First fit over the free regions, kept sorted and merged.
+//
+// Free regions are linked together through their first bytes, so every free
+// page must be accessible at its physical address. Nothing is ever allocated,
+// so the pool can be used under a lock the heap itself depends on.
+//
+// An all zero MemoryPool is a valid empty pool.
 class MemoryPool
 {
 private:
+    struct FreeExtent
+    {
+        FreeExtent *next;
+        size_t page_count;
+    };
+
+    FreeExtent *_head;
     size_t _quantity;
-    libruntime::Vector<MemoryRegion> _regions;
+
+    static FreeExtent *extent_at(uintptr_t page);
+
+    static uintptr_t page_of(FreeExtent *extent);
+
+    void unlink(FreeExtent *previous, FreeExtent *extent);
 
 public:
     size_t quantity() { return _quantity; }
 
-    MemoryPool() {}
+    MemoryPool() : _head(nullptr), _quantity(0) {}
 
     ~MemoryPool() {}
 
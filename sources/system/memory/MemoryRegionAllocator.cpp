@@ -1,21 +1,277 @@
+#include <libc/string.h>
+#include <libmath/MinMax.h>
+#include <libsystem/Assert.h>
+#include <libsystem/Logger.h>
 
+#include "system/System.h"
 #include "system/memory/MemoryRegionAllocator.h"
 
 namespace system::memory
 {
 
-MemoryRegion MemoryRegionAllocator::alloc_region(int how_many_pages)
+// Enough to track every page of a 32bit physical address space.
+#define MEMORY_SPAN_PAGE_COUNT (1024 * 1024)
+
+static uint32_t _bitmap_words[MEMORY_BITMAP_SIZE(MEMORY_SPAN_PAGE_COUNT) / sizeof(uint32_t)];
+
+#ifdef __CONFIG_MEMORY_ALLOCATOR_POOL__
+
+MemoryRegionAllocator::MemoryRegionAllocator()
+    : _bitmap(_bitmap_words, MEMORY_SPAN_PAGE_COUNT),
+      _total_pages(0),
+      _used_pages(0)
+{
+    libc::memset(_caches, 0, sizeof(_caches));
+}
+
+#else
+
+static uint8_t _buddy_bitmap[MEMORY_BUDDY_BITMAP_SIZE(MEMORY_SPAN_PAGE_COUNT)];
+
+MemoryRegionAllocator::MemoryRegionAllocator()
+    : _free_pool(MemoryRegion::from_page(0, MEMORY_SPAN_PAGE_COUNT), _buddy_bitmap),
+      _bitmap(_bitmap_words, MEMORY_SPAN_PAGE_COUNT),
+      _total_pages(0),
+      _used_pages(0)
+{
+    libc::memset(_caches, 0, sizeof(_caches));
+}
+
+#endif
+
+// Only runs of exactly 2^order pages are cached, so anything coming out of a
+// cache has the size the caller asked for.
+static int cache_order(size_t how_many_pages)
+{
+    for (int order = 0; order < MEMORY_CACHE_ORDER_COUNT; order++)
+    {
+        if ((1ul << order) == how_many_pages)
+        {
+            return order;
+        }
+    }
+
+    return -1;
+}
+
+static MemoryRegion clip_to_span(MemoryRegion region)
 {
+    if (region.base_page() >= MEMORY_SPAN_PAGE_COUNT)
+    {
+        return MemoryRegion::empty();
+    }
+
+    uintptr_t end_page = libmath::min(region.end_page(), (uintptr_t)MEMORY_SPAN_PAGE_COUNT);
+
+    return MemoryRegion::from_page(region.base_page(), end_page - region.base_page());
+}
+
+size_t MemoryRegionAllocator::free()
+{
+    size_t free_pages = _free_pool.quantity();
+
+    for (size_t cpu = 0; cpu < MAX_CPU_COUNT; cpu++)
+    {
+        for (int order = 0; order < MEMORY_CACHE_ORDER_COUNT; order++)
+        {
+            free_pages += _caches[cpu].count[order] << order;
+        }
+    }
+
+    return free_pages * arch::get_page_size();
+}
+
+void MemoryRegionAllocator::add_region(MemoryRegion region)
+{
+    region = clip_to_span(region);
+
+    if (region.is_empty())
+    {
+        return;
+    }
+
+    bool were_enabled = _lock.acquire_irqsave();
+
+    _total_pages += region.page_count();
+    _free_pool.put(region);
+
+    _lock.release_irqrestore(were_enabled);
+}
+
+void MemoryRegionAllocator::reserve_region(MemoryRegion region)
+{
+    region = clip_to_span(region);
+
+    if (region.is_empty())
+    {
+        return;
+    }
+
+    bool were_enabled = _lock.acquire_irqsave();
+
+    _total_pages += region.page_count();
+    __atomic_add_fetch(&_used_pages, region.page_count(), __ATOMIC_RELAXED);
+
+    if (!_bitmap.mark_used(region))
+    {
+        logger_fatal("{} is reserved twice!", region);
+        PANIC("Physical memory map overlaping!");
+    }
+
+    _lock.release_irqrestore(were_enabled);
+}
+
+MemoryRegion MemoryRegionAllocator::take_from_pool(size_t how_many_pages)
+{
+    bool were_enabled = _lock.acquire_irqsave();
+
     MemoryRegion result = _free_pool.take(how_many_pages);
-    _used_pool.put(result);
+
+    _lock.release_irqrestore(were_enabled);
+
+    return result;
+}
+
+// Must be called with interrupts disabled, on the cpu owning the cache.
+void MemoryRegionAllocator::refill_cache(MemoryCache &cache, int order)
+{
+    _lock.acquire();
+
+    while (cache.count[order] < MEMORY_CACHE_DEPTH / 2)
+    {
+        MemoryRegion region = _free_pool.take(1ul << order);
+
+        if (region.is_empty())
+        {
+            break;
+        }
+
+        cache.pages[order][cache.count[order]] = region.base_page();
+        cache.count[order]++;
+    }
+
+    _lock.release();
+}
+
+// Must be called with interrupts disabled, on the cpu owning the cache.
+void MemoryRegionAllocator::drain_cache(MemoryCache &cache, int order, size_t how_many)
+{
+    _lock.acquire();
+
+    while (how_many > 0 && cache.count[order] > 0)
+    {
+        cache.count[order]--;
+        _free_pool.put(MemoryRegion::from_page(cache.pages[order][cache.count[order]], 1ul << order));
+
+        how_many--;
+    }
+
+    _lock.release();
+}
+
+void MemoryRegionAllocator::flush_cache(MemoryCache &cache)
+{
+    for (int order = 0; order < MEMORY_CACHE_ORDER_COUNT; order++)
+    {
+        drain_cache(cache, order, MEMORY_CACHE_DEPTH);
+    }
+}
+
+MemoryRegion MemoryRegionAllocator::alloc_region(size_t how_many_pages)
+{
+    MemoryRegion result = MemoryRegion::empty();
+    int order = cache_order(how_many_pages);
+
+    if (order >= 0)
+    {
+        bool were_enabled = arch::disable_interrupts();
+        MemoryCache &cache = _caches[arch::get_current_cpu()];
+
+        if (cache.count[order] == 0)
+        {
+            refill_cache(cache, order);
+        }
+
+        if (cache.count[order] > 0)
+        {
+            cache.count[order]--;
+            result = MemoryRegion::from_page(cache.pages[order][cache.count[order]], how_many_pages);
+        }
+
+        arch::restore_interrupts(were_enabled);
+    }
+
+    if (result.is_empty())
+    {
+        result = take_from_pool(how_many_pages);
+    }
+
+    if (result.is_empty())
+    {
+        // Our own cache may be holding what the pool is missing.
+        bool were_enabled = arch::disable_interrupts();
+        flush_cache(_caches[arch::get_current_cpu()]);
+        arch::restore_interrupts(were_enabled);
+
+        result = take_from_pool(how_many_pages);
+    }
+
+    if (result.is_empty())
+    {
+        return result;
+    }
+
+    if (!_bitmap.mark_used(result))
+    {
+        logger_fatal("{} was handed out while already in use!", result);
+        PANIC("Physical memory allocator corrupted!");
+    }
+
+    __atomic_add_fetch(&_used_pages, result.page_count(), __ATOMIC_RELAXED);
 
     return result;
 }
 
 void MemoryRegionAllocator::free_region(MemoryRegion region)
 {
-    _free_pool.put(region);
-    _used_pool.take(region);
+    if (region.is_empty())
+    {
+        return;
+    }
+
+    if (!_bitmap.mark_free(region))
+    {
+        logger_fatal("Freeing {} which isn't in use!", region);
+        PANIC("Double free of physical memory!");
+    }
+
+    __atomic_sub_fetch(&_used_pages, region.page_count(), __ATOMIC_RELAXED);
+
+    int order = cache_order(region.page_count());
+
+    if (order >= 0)
+    {
+        bool were_enabled = arch::disable_interrupts();
+        MemoryCache &cache = _caches[arch::get_current_cpu()];
+
+        if (cache.count[order] == MEMORY_CACHE_DEPTH)
+        {
+            drain_cache(cache, order, MEMORY_CACHE_DEPTH / 2);
+        }
+
+        cache.pages[order][cache.count[order]] = region.base_page();
+        cache.count[order]++;
+
+        arch::restore_interrupts(were_enabled);
+    }
+    else
+    {
+        bool were_enabled = _lock.acquire_irqsave();
+
+        _free_pool.put(region);
+
+        _lock.release_irqrestore(were_enabled);
+    }
 }
 
 } // namespace system::memory
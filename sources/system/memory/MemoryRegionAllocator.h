@@ -1,27 +1,67 @@
 #pragma once
 
+#include <libruntime/TicketLock.h>
+
 #include "arch/Arch.h"
+#include "system/System.h"
+#include "system/memory/MemoryBitmap.h"
+#include "system/memory/MemoryBuddy.h"
 #include "system/memory/MemoryPool.h"
 
 namespace system::memory
 {
 
+// Runs of 1, 2, 4, 8 and 16 pages are cached on each cpu.
+#define MEMORY_CACHE_ORDER_COUNT 5
+#define MEMORY_CACHE_DEPTH 8
+
+struct MemoryCache
+{
+    size_t count[MEMORY_CACHE_ORDER_COUNT];
+    uintptr_t pages[MEMORY_CACHE_ORDER_COUNT][MEMORY_CACHE_DEPTH];
+};
+
 class MemoryRegionAllocator
 {
 private:
+    libruntime::TicketLock _lock;
+
+#ifdef __CONFIG_MEMORY_ALLOCATOR_POOL__
     MemoryPool _free_pool;
-    MemoryPool _used_pool;
+#else
+    MemoryBuddy _free_pool;
+#endif
+
+    MemoryBitmap _bitmap;
+    MemoryCache _caches[MAX_CPU_COUNT];
+
+    size_t _total_pages;
+    size_t _used_pages;
+
+    MemoryRegion take_from_pool(size_t how_many_pages);
+
+    void refill_cache(MemoryCache &cache, int order);
+
+    void drain_cache(MemoryCache &cache, int order, size_t how_many);
+
+    void flush_cache(MemoryCache &cache);
 
 public:
-    size_t used() { return _used_pool.quantity() * arch::get_page_size(); }
-    size_t free() { return _free_pool.quantity() * arch::get_page_size(); }
-    size_t total() { return used() + free(); }
+    size_t used() { return __atomic_load_n(&_used_pages, __ATOMIC_RELAXED) * arch::get_page_size(); }
+    size_t free();
+    size_t total() { return _total_pages * arch::get_page_size(); }
 
-    MemoryRegionAllocator() {}
+    MemoryRegionAllocator();
 
     ~MemoryRegionAllocator() {}
 
-    MemoryRegion alloc_region(int how_many_pages);
+    // Make a region of free physical memory available to the allocator.
+    void add_region(MemoryRegion region);
+
+    // Make a region of physical memory known to the allocator, but already in use.
+    void reserve_region(MemoryRegion region);
+
+    MemoryRegion alloc_region(size_t how_many_pages);
 
     void free_region(MemoryRegion region);
 };
@@ -12,6 +12,21 @@ class Thread;
 namespace system::scheduling
 {
 
+#define BLOCKER_TYPE_LIST(__ENTRY) \
+    __ENTRY(SLEEP)                 \
+    __ENTRY(MUTEX)                 \
+    __ENTRY(WAIT)                  \
+    __ENTRY(JOIN)
+
+#define BLOCKER_TYPE_ENUM_ENTRY(__x) __x,
+
+enum class BlockerType
+{
+    BLOCKER_TYPE_LIST(BLOCKER_TYPE_ENUM_ENTRY) __COUNT
+};
+
+// Blocked threads are never polled, whatever makes should_unblock() true
+// must call scheduling::wakeup() on the thread.
 class Blocker
 {
 private:
@@ -20,6 +35,9 @@ public:
 
     virtual ~Blocker() {}
 
+    // What the thread is waiting for, it's accounted for separately.
+    virtual BlockerType type() = 0;
+
     virtual bool should_unblock() = 0;
 
     virtual void unblock() = 0;
@@ -4,7 +4,39 @@
 /* This code is licensed under the 3-Clause BSD License.                      */
 /* See: LICENSE.md                                                            */
 
+#include <libruntime/IntrusiveList.h>
+#include <libruntime/Pool.h>
+
+#include "system/scheduling/Blocker.h"
+
 namespace system::scheduling
 {
 
+// Wait for a Mutex to be handed over by its previous owner.
+class BlockerMutex : public Blocker, public libruntime::Pooled<BlockerMutex>
+{
+private:
+    system::tasking::Thread *_thread;
+    volatile bool _acquired = false;
+
+public:
+    // Link the blocker in the waiters of the mutex.
+    libruntime::IntrusiveListNode node;
+
+    system::tasking::Thread *thread() { return _thread; }
+
+    BlockerMutex(system::tasking::Thread *thread) : _thread(thread) {}
+
+    ~BlockerMutex() {}
+
+    BlockerType type() { return BlockerType::MUTEX; }
+
+    // The blocker may go away as soon as this is called.
+    void acquired() { _acquired = true; }
+
+    bool should_unblock() { return _acquired; }
+
+    void unblock() {}
+};
+
 } // namespace system::scheduling
@@ -4,28 +4,41 @@
 /* This code is licensed under the 3-Clause BSD License.                      */
 /* See: LICENSE.md                                                            */
 
+#include <libruntime/Pool.h>
+
 #include "system/System.h"
 #include "system/scheduling/Blocker.h"
+#include "system/scheduling/Scheduling.h"
+#include "system/scheduling/Timer.h"
 
 namespace system::scheduling
 {
 
-class BlockerSleep : public Blocker
+class BlockerSleep : public Blocker, public libruntime::Pooled<BlockerSleep>
 {
 private:
-    uint32_t _wakeup_tick;
+    Timer _timer;
+
+    static void expired(void *thread)
+    {
+        wakeup(*static_cast<system::tasking::Thread *>(thread));
+    }
 
 public:
-    BlockerSleep(uint32_t how_long)
+    // The blocker belongs to the thread, so it can't go away before the timer.
+    BlockerSleep(system::tasking::Thread *thread, uint64_t how_long)
+        : _timer(expired, thread)
     {
-        _wakeup_tick = system::get_tick() + how_long;
+        _timer.start(how_long);
     }
 
     ~BlockerSleep() {}
 
+    BlockerType type() { return BlockerType::SLEEP; }
+
     bool should_unblock()
     {
-        return _wakeup_tick <= system::get_tick();
+        return _timer.deadline() <= system::get_tick();
     }
 
     void unblock()
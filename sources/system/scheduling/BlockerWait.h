@@ -4,7 +4,40 @@
 /* This code is licensed under the 3-Clause BSD License.                      */
 /* See: LICENSE.md                                                            */
 
+#include <libruntime/IntrusiveList.h>
+#include <libruntime/Pool.h>
+
+#include "system/scheduling/Blocker.h"
+
 namespace system::scheduling
 {
 
+// Wait in a WaitQueue until someone wake us up.
+class BlockerWait : public Blocker, public libruntime::Pooled<BlockerWait>
+{
+private:
+    system::tasking::Thread *_thread;
+    BlockerType _type;
+    volatile bool _woken = false;
+
+public:
+    // Link the blocker in the waiters of the queue.
+    libruntime::IntrusiveListNode node;
+
+    system::tasking::Thread *thread() { return _thread; }
+
+    BlockerWait(system::tasking::Thread *thread, BlockerType type) : _thread(thread), _type(type) {}
+
+    ~BlockerWait() {}
+
+    BlockerType type() { return _type; }
+
+    // The blocker may go away as soon as this is called.
+    void woken() { _woken = true; }
+
+    bool should_unblock() { return _woken; }
+
+    void unblock() {}
+};
+
 } // namespace system::scheduling
@@ -0,0 +1,27 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include "system/scheduling/Mutex.h"
+#include "system/scheduling/WaitQueue.h"
+
+namespace system::scheduling
+{
+
+// A condition variable, always used with the same Mutex.
+class Condition
+{
+private:
+    WaitQueue _queue;
+
+public:
+    void wait(Mutex &mutex) { _queue.wait(mutex); }
+
+    void signal() { _queue.wake_one(); }
+
+    void broadcast() { _queue.wake_all(); }
+};
+
+} // namespace system::scheduling
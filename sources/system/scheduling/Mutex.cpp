@@ -0,0 +1,108 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/CpuRelax.h>
+#include <libsystem/Assert.h>
+
+#include "arch/Arch.h"
+#include "system/scheduling/Mutex.h"
+#include "system/scheduling/Scheduling.h"
+
+namespace system::scheduling
+{
+
+bool Mutex::try_acquire()
+{
+    if (!__sync_bool_compare_and_swap(&_locked, false, true))
+    {
+        return false;
+    }
+
+    _owner = running_thread().necked();
+
+    return true;
+}
+
+void Mutex::acquire()
+{
+    // Spinning only pays off while the owner is running, and may release the
+    // mutex soon. A preempted or blocked owner won't, we would burn our time
+    // for nothing. It's unknown for a moment after it's taken, keep trying.
+    for (int i = 0; i < MUTEX_SPIN_COUNT; i++)
+    {
+        if (try_acquire())
+        {
+            return;
+        }
+
+        system::tasking::Thread *owner = _owner;
+
+        if (owner != nullptr && !is_running_on_other_cpu(owner))
+        {
+            break;
+        }
+
+        libruntime::cpu_relax();
+    }
+
+    bool were_enabled = arch::disable_interrupts();
+    assert(were_enabled);
+
+    _lock.acquire();
+
+    // It may have been released while we were taking the lock, release()
+    // only clears _locked when nobody is waiting.
+    if (try_acquire())
+    {
+        _lock.release();
+        arch::restore_interrupts(were_enabled);
+
+        return;
+    }
+
+    auto thread = running_thread();
+    auto blocker = new BlockerMutex(thread.necked());
+
+    _waiters.push_back(*blocker);
+
+    _lock.release();
+    arch::restore_interrupts(were_enabled);
+
+    // We own the mutex once this returns.
+    thread->block(blocker);
+}
+
+void Mutex::release()
+{
+    assert(_locked);
+
+    bool were_enabled = arch::disable_interrupts();
+    _lock.acquire();
+
+    if (_waiters.empty())
+    {
+        _owner = nullptr;
+        _locked = false;
+
+        _lock.release();
+        arch::restore_interrupts(were_enabled);
+
+        return;
+    }
+
+    BlockerMutex *next = _waiters.pop();
+
+    // Take a reference before, the blocker may be freed as soon as the thread sees it.
+    libruntime::RefPtr<system::tasking::Thread> thread = *next->thread();
+    _owner = next->thread();
+    next->acquired();
+
+    _lock.release();
+
+    wakeup(thread);
+
+    arch::restore_interrupts(were_enabled);
+}
+
+} // namespace system::scheduling
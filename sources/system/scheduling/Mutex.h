@@ -0,0 +1,56 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/IntrusiveList.h>
+#include <libruntime/Macros.h>
+#include <libruntime/SpinLock.h>
+
+#include "system/scheduling/BlockerMutex.h"
+
+namespace system::scheduling
+{
+
+// How many times acquire() retries at most before putting the thread to
+// sleep, while the owner is running, most critical sections are shorter than
+// a context switch.
+#define MUTEX_SPIN_COUNT 128
+
+// A lock which blocks the threads waiting for it instead of burning their
+// timeslice. Waiters get the mutex in FIFO order, it is handed over by
+// release() without ever being unlocked in between.
+//
+// Never take it from an interrupt, or with interrupts disabled.
+// An all zero Mutex is a valid unlocked mutex.
+class Mutex
+{
+private:
+    volatile bool _locked = false;
+
+    // Only compared to the running threads, it may be gone by then.
+    system::tasking::Thread *volatile _owner = nullptr;
+
+    // Protect the waiters, and the hand-off.
+    libruntime::SpinLock _lock;
+    libruntime::IntrusiveList<BlockerMutex, &BlockerMutex::node> _waiters;
+
+public:
+    Mutex() {}
+
+    ~Mutex() {}
+
+    __noncopyable(Mutex);
+    __nonmovable(Mutex);
+
+    bool is_acquired() { return _locked; }
+
+    bool try_acquire();
+
+    void acquire();
+
+    void release();
+};
+
+} // namespace system::scheduling
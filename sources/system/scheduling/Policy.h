@@ -7,13 +7,48 @@
 namespace system::scheduling
 {
 
+#define SCHEDULING_PRIORITY_LEVELS 32
+
+// Level zero is only used by the idle class.
+#define SCHEDULING_PRIORITY_IDLE 0
+#define SCHEDULING_PRIORITY_MIN 1
+#define SCHEDULING_PRIORITY_MAX (SCHEDULING_PRIORITY_LEVELS - 1)
+
+// Decide at which priority a thread runs and for how long, in scheduler
+// ticks. The scheduler does the accounting and calls back when the thread
+// used its whole timeslice or gave the cpu back before.
 class Policy
 {
 private:
-    /* data */
+    int _remaining = 0;
+
 public:
     Policy() {}
     virtual ~Policy() {}
+
+    virtual int priority() = 0;
+
+    virtual int timeslice() = 0;
+
+    virtual bool is_idle() { return false; }
+
+    // The thread used its whole timeslice.
+    virtual void expired() {}
+
+    // The thread blocked before the end of its timeslice.
+    virtual void yielded() {}
+
+    bool has_expired() { return _remaining <= 0; }
+
+    // Return true once the timeslice is used up.
+    bool tick()
+    {
+        _remaining--;
+
+        return _remaining <= 0;
+    }
+
+    void refill() { _remaining = timeslice(); }
 };
 
 } // namespace system::scheduling
@@ -4,16 +4,23 @@
 /* This code is licensed under the 3-Clause BSD License.                      */
 /* See: LICENSE.md                                                            */
 
+#include "system/scheduling/Policy.h"
+
 namespace system::scheduling
 {
 
-class PolicyIdle
+// Only run when nothing else is ready, idle threads are never queued.
+class PolicyIdle : public Policy
 {
-private:
-    /* data */
 public:
-    PolicyIdle(/* args */) {}
+    PolicyIdle() {}
     ~PolicyIdle() {}
+
+    int priority() { return SCHEDULING_PRIORITY_IDLE; }
+
+    int timeslice() { return 1; }
+
+    bool is_idle() { return true; }
 };
 
 } // namespace system::scheduling
@@ -4,16 +4,47 @@
 /* This code is licensed under the 3-Clause BSD License.                      */
 /* See: LICENSE.md                                                            */
 
+#include <libmath/MinMax.h>
+
+#include "system/scheduling/Policy.h"
+
 namespace system::scheduling
 {
 
-class PolicyNormal
+#define POLICY_NORMAL_PRIORITY 16
+#define POLICY_NORMAL_TIMESLICE 10
+
+// How far the priority can move away from the base one.
+#define POLICY_NORMAL_BONUS_MAX 4
+
+// Threads which block before the end of their timeslice, like the ones
+// waiting for I/O, climb above the ones which burn all of it.
+class PolicyNormal : public Policy
 {
 private:
-    /* data */
+    int _base_priority;
+    int _bonus = 0;
+
 public:
-    PolicyNormal(/* args */) {}
+    PolicyNormal(int base_priority = POLICY_NORMAL_PRIORITY) : _base_priority(base_priority) {}
     ~PolicyNormal() {}
+
+    int priority()
+    {
+        return libmath::clamp(_base_priority + _bonus, SCHEDULING_PRIORITY_MIN, SCHEDULING_PRIORITY_MAX);
+    }
+
+    int timeslice() { return POLICY_NORMAL_TIMESLICE; }
+
+    void expired()
+    {
+        _bonus = libmath::max(_bonus - 1, -POLICY_NORMAL_BONUS_MAX);
+    }
+
+    void yielded()
+    {
+        _bonus = libmath::min(_bonus + 1, POLICY_NORMAL_BONUS_MAX);
+    }
 };
 
 } // namespace system::scheduling
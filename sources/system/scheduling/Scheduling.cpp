@@ -4,12 +4,16 @@
 
 #include <libsystem/__plugs__.h>
 
-#include <libruntime/LinkedList.h>
-#include <libruntime/SpinLock.h>
+#include <libmath/Divide.h>
+#include <libruntime/IntrusiveList.h>
+#include <libruntime/TicketLock.h>
 #include <libsystem/Logger.h>
 
 #include "arch/Arch.h"
+#include "system/System.h"
 #include "system/scheduling/Scheduling.h"
+#include "system/scheduling/Timer.h"
+#include "system/trace/Trace.h"
 
 using namespace libruntime;
 using namespace system::tasking;
@@ -17,125 +21,673 @@ using namespace system::tasking;
 namespace system::scheduling
 {
 
-static RefPtr<Thread> _running_thread;
-static LinkedList<RefPtr<Thread>> *_ready_threads;
-static LinkedList<RefPtr<Thread>> *_blocked_threads;
+// How many threads an idle cpu can take from an other one at once.
+#define SCHEDULING_STEAL_MAX 4
 
-libruntime::SpinLock _threads_lock;
+// One list per priority level, and a bit set in the bitmap for each of them
+// which isn't empty, so the highest ready level is found in O(1).
+// All zero is a valid empty queue.
+//
+// The queue owns the reference of a ready thread, it is moved in and out of
+// it, so switching between ready threads never touch their refcount. Threads
+// are linked through their queue_node, so nothing is allocated either.
+struct RunQueue
+{
+    TicketLock lock;
+    IntrusiveList<Thread, &Thread::queue_node> levels[SCHEDULING_PRIORITY_LEVELS];
+    uint32_t bitmap;
+    size_t count;
+
+    size_t switches;
+    size_t steals;
+    size_t migrations;
+
+    // Preempted threads go back at the front of their level, since they
+    // didn't use their whole timeslice.
+    void push(RefPtr<Thread> thread, bool front)
+    {
+        int level = thread->policy().priority();
+        Thread &owned = *thread.give_ref();
+
+        if (front)
+        {
+            levels[level].push(owned);
+        }
+        else
+        {
+            levels[level].push_back(owned);
+        }
+
+        bitmap |= 1u << level;
+        count++;
+    }
+
+    // Take the first thread of a level matching the predicate.
+    template <typename Predicate>
+    RefPtr<Thread> take(int level, Predicate predicate)
+    {
+        Thread *thread = levels[level].take_if(predicate);
+
+        if (levels[level].empty())
+        {
+            bitmap &= ~(1u << level);
+        }
+
+        if (!thread)
+        {
+            return nullptr;
+        }
+
+        count--;
+
+        return adopt(*thread);
+    }
+
+    // Drop the reference of the queue, the caller must hold one.
+    void remove(Thread *thread)
+    {
+        if (!IntrusiveList<Thread, &Thread::queue_node>::is_linked(*thread))
+        {
+            return;
+        }
+
+        int level = thread->policy().priority();
+
+        levels[level].remove(*thread);
+        count--;
+
+        if (levels[level].empty())
+        {
+            bitmap &= ~(1u << level);
+        }
+
+        thread->deref();
+    }
+
+    // The priority of the best thread in the queue, or -1 if there is none.
+    int highest_priority()
+    {
+        uint32_t bits = bitmap;
+
+        if (bits == 0)
+        {
+            return -1;
+        }
+
+        return 31 - __builtin_clz(bits);
+    }
+};
+
+static RunQueue _run_queues[MAX_CPU_COUNT];
+
+static RefPtr<Thread> _running_threads[MAX_CPU_COUNT];
+static RefPtr<Thread> _idle_threads[MAX_CPU_COUNT];
+
+// The thread a cpu just switched away from, its stack is in use until the
+// switch is done, so no other cpu may pick it until this cpu schedules again.
+static Thread *_previous_threads[MAX_CPU_COUNT];
+
+// The reference of the previous thread, if it didn't go back in the run
+// queue, so it is still alive while we are on its stack.
+static RefPtr<Thread> _released_threads[MAX_CPU_COUNT];
+
+// Set while a cpu runs its idle thread, its tick may be stopped so it must
+// be kicked when there is work for it.
+static volatile bool _idling[MAX_CPU_COUNT];
+
+// When each cpu got its idle thread, what its idle time is compared to.
+static uint64_t _online_since[MAX_CPU_COUNT];
+
+// Taken to block or wake up a thread, blocked threads are not tracked by
+// the scheduler, their blocker is responsible for waking them up.
+static TicketLock _blocked_lock;
 
 void initialize()
 {
     logger_info("Initializing scheduling");
+}
 
-    _ready_threads = new LinkedList<RefPtr<Thread>>();
-    _blocked_threads = new LinkedList<RefPtr<Thread>>();
+// A cpu is online once it has an idle thread.
+static bool is_online(int cpu)
+{
+    return _idle_threads[cpu] != nullptr;
 }
 
-void update_thread_state(RefPtr<Thread> thread, ThreadState new_state)
+static bool is_on_other_cpu(Thread *thread, int current_cpu)
 {
-    _threads_lock.acquire();
+    for (int cpu = 0; cpu < MAX_CPU_COUNT; cpu++)
+    {
+        if (cpu != current_cpu &&
+            (_running_threads[cpu] == thread || _previous_threads[cpu] == thread))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
 
-    if (thread->state() == ThreadState::EMBRYO)
+static int least_loaded_cpu()
+{
+    int result = arch::get_current_cpu();
+
+    for (int cpu = 0; cpu < MAX_CPU_COUNT; cpu++)
     {
-        if (_running_thread == nullptr)
+        if (is_online(cpu) && _run_queues[cpu].count < _run_queues[result].count)
         {
-            logger_info("Using {} has running thread", thread);
-            _running_thread = thread;
+            result = cpu;
         }
     }
-    else if (thread->state() == ThreadState::BLOCKED)
+
+    return result;
+}
+
+// Wake up the cpu if it is idle, or else any idle cpu so it can steal the thread.
+static void kick_idle_cpu(int cpu)
+{
+    int current_cpu = arch::get_current_cpu();
+
+    if (_idling[cpu])
     {
-        _blocked_threads->remove(thread);
+        arch::kick_cpu(cpu);
+
+        return;
     }
-    else if (thread->state() == ThreadState::READY)
+
+    for (int other = 0; other < MAX_CPU_COUNT; other++)
     {
-        _ready_threads->remove(thread);
+        if (other != current_cpu && is_online(other) && _idling[other])
+        {
+            arch::kick_cpu(other);
+
+            return;
+        }
     }
+}
 
-    thread->set_state(new_state);
+static void enqueue(RefPtr<Thread> thread, int cpu)
+{
+    RunQueue &queue = _run_queues[cpu];
+
+    queue.lock.acquire();
+
+    thread->set_cpu(cpu);
+    queue.push(move(thread), false);
+
+    queue.lock.release();
+
+    kick_idle_cpu(cpu);
+}
+
+static void dequeue(RefPtrView<Thread> thread)
+{
+    // The thread may be stolen while we are waiting for the lock of its queue.
+    while (true)
+    {
+        RunQueue &queue = _run_queues[thread->cpu()];
+
+        queue.lock.acquire();
+
+        if (&_run_queues[thread->cpu()] == &queue)
+        {
+            queue.remove(thread.necked());
+            queue.lock.release();
+
+            return;
+        }
+
+        queue.lock.release();
+    }
+}
+
+void set_idle_thread(int cpu, RefPtr<Thread> thread)
+{
+    bool were_enabled = arch::disable_interrupts();
+
+    thread->set_cpu(cpu);
+    _idle_threads[cpu] = move(thread);
+    _online_since[cpu] = arch::clock_cycles();
+
+    arch::restore_interrupts(were_enabled);
+}
+
+void update_thread_state(RefPtrView<Thread> thread, ThreadState new_state)
+{
+    bool were_enabled = arch::disable_interrupts();
+    int cpu = arch::get_current_cpu();
+
+    bool is_idle = thread->policy().is_idle();
+    bool is_new = thread->state() == ThreadState::EMBRYO;
+
+    if (is_new)
+    {
+        if (_running_threads[cpu] == nullptr && !is_idle)
+        {
+            thread->set_cpu(cpu);
+            _running_threads[cpu] = thread;
+        }
+    }
+    else if (thread->state() == ThreadState::READY && !is_idle)
+    {
+        dequeue(thread);
+    }
 
-    if (thread->state() == ThreadState::BLOCKED)
+    if (new_state == ThreadState::BLOCKED)
     {
-        _blocked_threads->push_back(thread);
+        _blocked_lock.acquire();
+
+        // The event may have happened while we were getting ready to block,
+        // its wakeup() found the thread still running and did nothing.
+        if (thread->should_unblock())
+        {
+            thread->unblock();
+
+            _blocked_lock.release();
+            arch::restore_interrupts(were_enabled);
+
+            return;
+        }
+
+        thread->set_state(ThreadState::BLOCKED);
+
+        _blocked_lock.release();
+        arch::restore_interrupts(were_enabled);
+
+        return;
     }
-    else if (thread->state() == ThreadState::READY)
+
+    thread->set_state(new_state);
+
+    if (thread->state() == ThreadState::READY && !is_idle)
     {
-        _ready_threads->push_back(thread);
+        enqueue(thread, is_new ? least_loaded_cpu() : thread->cpu());
     }
-    else if (thread->state() == ThreadState::STOPPED)
+
+    arch::restore_interrupts(were_enabled);
+}
+
+// Interrupts are disabled so we can't be moved to an other cpu in between.
+bool is_running_on_other_cpu(Thread *thread)
+{
+    bool were_enabled = arch::disable_interrupts();
+
+    int current_cpu = arch::get_current_cpu();
+    bool result = false;
+
+    for (int cpu = 0; cpu < MAX_CPU_COUNT; cpu++)
     {
+        if (cpu != current_cpu && _running_threads[cpu] == thread)
+        {
+            result = true;
+            break;
+        }
     }
 
-    _threads_lock.release();
+    arch::restore_interrupts(were_enabled);
+
+    return result;
 }
 
 libruntime::RefPtr<system::tasking::Thread> running_thread()
 {
-    assert(_running_thread != nullptr);
+    bool were_enabled = arch::disable_interrupts();
+
+    RefPtr<Thread> thread = _running_threads[arch::get_current_cpu()];
+
+    arch::restore_interrupts(were_enabled);
 
-    return _running_thread;
+    assert(thread != nullptr);
+
+    return thread;
 }
 
 libruntime::RefPtr<system::tasking::Process> running_process()
 {
-    assert(_running_thread != nullptr);
-
-    return _running_thread->process();
+    return running_thread()->process();
 }
 
 bool can_schedule()
 {
-    return !__plugs__::memory_is_lock() &&
-           !_threads_lock.is_acquired();
+    return !__plugs__::memory_is_lock();
 }
 
-static void unblock_blocked_thread()
+void wakeup(RefPtrView<Thread> thread)
 {
-    _blocked_threads->foreach ([](auto thread) {
-        if (thread->should_unblock())
+    bool were_enabled = _blocked_lock.acquire_irqsave();
+
+    if (thread->state() == ThreadState::BLOCKED && thread->should_unblock())
+    {
+        trace::record(trace::TraceEvent::WAKEUP, thread->id(), thread->cpu());
+
+        thread->unblock();
+        thread->set_state(ThreadState::READY);
+        enqueue(thread, thread->cpu());
+    }
+
+    _blocked_lock.release_irqrestore(were_enabled);
+}
+
+// Must be called with the lock of the queue held.
+static RefPtr<Thread> take_ready_thread(RunQueue &queue, int cpu)
+{
+    RefPtr<Thread> result;
+    uint32_t bits = queue.bitmap;
+
+    // The first thread of the highest level is almost always the one, the
+    // others are only looked at if it is still on the stack of an other cpu.
+    while (bits != 0 && !result)
+    {
+        int level = 31 - __builtin_clz(bits);
+        bits &= ~(1u << level);
+
+        result = queue.take(level, [&](Thread &thread) {
+            return !is_on_other_cpu(&thread, cpu);
+        });
+    }
+
+    return result;
+}
+
+// Take up to half of the threads of the busiest cpu and put them in our own queue.
+static void steal_threads(int cpu)
+{
+    int busiest = -1;
+    size_t busiest_count = 0;
+
+    for (int other = 0; other < MAX_CPU_COUNT; other++)
+    {
+        size_t count = _run_queues[other].count;
+
+        if (other != cpu && count > busiest_count)
         {
-            logger_info("Unblocking {}", thread);
-            thread->unblock();
-            thread->set_state(ThreadState::READY);
-            _blocked_threads->remove(thread);
-            _ready_threads->push_back(thread);
+            busiest = other;
+            busiest_count = count;
+        }
+    }
+
+    if (busiest == -1)
+    {
+        return;
+    }
+
+    RefPtr<Thread> stolen[SCHEDULING_STEAL_MAX];
+    size_t stolen_count = 0;
+
+    RunQueue &victim = _run_queues[busiest];
+
+    victim.lock.acquire();
+
+    size_t to_steal = (victim.count + 1) / 2;
+
+    while (stolen_count < to_steal && stolen_count < SCHEDULING_STEAL_MAX)
+    {
+        auto thread = take_ready_thread(victim, cpu);
+
+        if (!thread)
+        {
+            break;
         }
 
-        return Iteration::CONTINUE;
-    });
+        thread->set_cpu(cpu);
+        stolen[stolen_count] = move(thread);
+        stolen_count++;
+    }
+
+    victim.lock.release();
+
+    if (stolen_count == 0)
+    {
+        return;
+    }
+
+    RunQueue &queue = _run_queues[cpu];
+
+    queue.lock.acquire();
+
+    for (size_t i = 0; i < stolen_count; i++)
+    {
+        queue.push(move(stolen[i]), false);
+    }
+
+    queue.steals++;
+    queue.migrations += stolen_count;
+
+    queue.lock.release();
 }
 
-uintptr_t schedule(uintptr_t stack_pointer)
+bool should_preempt()
 {
-    if (_running_thread == nullptr)
+    int cpu = arch::get_current_cpu();
+
+    Thread *running = _running_threads[cpu].necked();
+
+    // Let schedule() adopt the idle thread.
+    if (running == nullptr)
     {
-        return stack_pointer;
+        return true;
     }
 
-    if (can_schedule())
+    // An idle cpu looks for work every time it wakes up, it may have to steal it.
+    if (running->policy().is_idle())
     {
-        _threads_lock.acquire();
+        return true;
+    }
 
-        _running_thread->stack().set_pointer(stack_pointer);
+    return running->policy().has_expired() ||
+           _run_queues[cpu].highest_priority() > running->policy().priority();
+}
+
+bool tick()
+{
+    int cpu = arch::get_current_cpu();
+
+    Thread *running = _running_threads[cpu].necked();
 
-        unblock_blocked_thread();
+    if (running != nullptr && !running->policy().is_idle())
+    {
+        running->policy().tick();
+    }
+
+    return should_preempt();
+}
 
-        if (_running_thread->state() == ThreadState::RUNNING)
+// A preempted thread keeps its place in the run queue, one which yields
+// while it could still run goes behind the others.
+static void reschedule(bool preempted)
+{
+    int cpu = arch::get_current_cpu();
+
+    if (_running_threads[cpu] == nullptr)
+    {
+        if (_idle_threads[cpu] == nullptr)
         {
-            _ready_threads->push_back(_running_thread);
-            _running_thread->set_state(ThreadState::READY);
+            return;
         }
 
-        _running_thread = RefPtr(*_ready_threads->pop());
-        _running_thread->set_state(ThreadState::RUNNING);
+        _running_threads[cpu] = _idle_threads[cpu];
+        _running_threads[cpu]->set_state(ThreadState::RUNNING);
+    }
+
+    // We are back on the stack of the running thread, the previous one is free to go.
+    _previous_threads[cpu] = nullptr;
+    _released_threads[cpu] = nullptr;
+
+    Thread *running = _running_threads[cpu].necked();
+
+    RunQueue &queue = _run_queues[cpu];
+
+    queue.lock.acquire();
 
-        _threads_lock.release();
+    Policy &policy = running->policy();
 
-        return _running_thread->stack().get_pointer();
+    // It could have gone on, the switch isn't its choice.
+    bool involuntary = preempted && running->state() == ThreadState::RUNNING;
+
+    if (policy.is_idle())
+    {
+        // Nothing to account for, the idle thread is never queued.
+    }
+    else if (running->state() == ThreadState::RUNNING)
+    {
+        bool expired = policy.has_expired();
+
+        if (expired)
+        {
+            policy.expired();
+        }
+        else if (!preempted)
+        {
+            policy.yielded();
+        }
+
+        running->set_state(ThreadState::READY);
+
+        // Other cpus may take it as soon as the queue is unlocked, while we
+        // are still on its stack, they must see it as ours from now on.
+        _previous_threads[cpu] = running;
+        queue.push(move(_running_threads[cpu]), preempted && !expired);
+    }
+    else if (!policy.has_expired())
+    {
+        policy.yielded();
+    }
+
+    RefPtr<Thread> next = take_ready_thread(queue, cpu);
+
+    queue.lock.release();
+
+    if (!next)
+    {
+        steal_threads(cpu);
+
+        queue.lock.acquire();
+        next = take_ready_thread(queue, cpu);
+        queue.lock.release();
+    }
+
+    // The running thread is still there if it wasn't put back in the queue,
+    // it's either the idle thread, or blocked or stopped.
+    bool keep_running = !next && (running->state() == ThreadState::RUNNING || _idle_threads[cpu] == nullptr);
+
+    if (!keep_running)
+    {
+        if (!next)
+        {
+            next = _idle_threads[cpu];
+        }
+
+        if (next != running)
+        {
+            _previous_threads[cpu] = running;
+            queue.switches++;
+
+            if (running->policy().is_idle())
+            {
+                // It's never queued, but it stops running as far as the accounting goes.
+                running->set_state(ThreadState::READY);
+            }
+            else
+            {
+                running->account_switch(!involuntary);
+            }
+
+            trace::record(trace::TraceEvent::SWITCH, running->id(), next->id(), static_cast<uint32_t>(running->state()));
+        }
+
+        if (_running_threads[cpu] != nullptr)
+        {
+            _released_threads[cpu] = move(_running_threads[cpu]);
+        }
+
+        _running_threads[cpu] = move(next);
+    }
+
+    Thread *current = _running_threads[cpu].necked();
+
+    if (current->policy().has_expired())
+    {
+        current->policy().refill();
+    }
+
+    current->set_cpu(cpu);
+    current->set_state(ThreadState::RUNNING);
+
+    if (current->policy().is_idle())
+    {
+        _idling[cpu] = true;
+        __sync_synchronize();
+
+        // A thread enqueued before we were marked idle didn't kick us.
+        if (queue.count == 0)
+        {
+            arch::stop_tick(next_timer_deadline());
+        }
+        else
+        {
+            arch::start_tick();
+        }
     }
     else
     {
-        return stack_pointer;
+        _idling[cpu] = false;
+        arch::start_tick();
+    }
+
+    current->process()->address_space().switch_to();
+
+    // The running thread is kept alive by the run queue or _released_threads
+    // until the next schedule() on this cpu, which is on an other stack.
+    if (current != running)
+    {
+        arch::switch_context(*running, *current);
+    }
+}
+
+void schedule()
+{
+    reschedule(true);
+}
+
+void yield()
+{
+    // The heap lock is held with interrupts disabled, nothing preempts its
+    // holder, and it must not give the cpu away either.
+    assert(can_schedule());
+
+    bool were_enabled = arch::disable_interrupts();
+
+    reschedule(false);
+
+    arch::restore_interrupts(were_enabled);
+}
+
+void dump_statistics()
+{
+    logger_info("cpu  running  queued  switches  steals  migrations  idle%");
+
+    for (int cpu = 0; cpu < MAX_CPU_COUNT; cpu++)
+    {
+        if (!is_online(cpu))
+        {
+            continue;
+        }
+
+        RunQueue &queue = _run_queues[cpu];
+
+        bool were_enabled = queue.lock.acquire_irqsave();
+
+        int running = _running_threads[cpu] ? _running_threads[cpu]->id() : -1;
+        size_t queued = queue.count;
+        size_t switches = queue.switches;
+        size_t steals = queue.steals;
+        size_t migrations = queue.migrations;
+
+        queue.lock.release_irqrestore(were_enabled);
+
+        uint64_t online = arch::clock_cycles() - _online_since[cpu];
+        size_t idle = libmath::percent(_idle_threads[cpu]->accounting().running, online);
+
+        logger_info("{}  {}  {}  {}  {}  {}  {}", cpu, running, queued, switches, steals, migrations, idle);
     }
 }
 
@@ -12,12 +12,44 @@ namespace system::scheduling
 
 void initialize();
 
-void update_thread_state(libruntime::RefPtr<system::tasking::Thread> thread, system::tasking::ThreadState new_state);
+void update_thread_state(libruntime::RefPtrView<system::tasking::Thread> thread, system::tasking::ThreadState new_state);
 
-uintptr_t schedule(uintptr_t stack_pointer);
+// The idle thread of a cpu runs when nothing else is ready, it is never put
+// in the ready list. An application processor starts on the stack of its idle
+// thread and adopt it on the first schedule.
+void set_idle_thread(int cpu, libruntime::RefPtr<system::tasking::Thread> thread);
+
+// Account for a timer tick on the current cpu, return true if the running
+// thread should be preempted: its timeslice is used up, or a thread with an
+// higher priority is ready.
+bool tick();
+
+// Same as tick(), without accounting for the time, for interrupts which
+// aren't from the clock.
+bool should_preempt();
+
+// Make a blocked thread ready if its blocker agree, must be called by
+// whatever could make the blocker of the thread want to unblock.
+void wakeup(libruntime::RefPtrView<system::tasking::Thread> thread);
+
+// Switch to the next thread, and only return once the running thread is
+// switched back to. Must be called with interrupts disabled, by an interrupt
+// which preempts the running thread, or by yield().
+void schedule();
+
+// Give the cpu to the next thread without going through an interrupt, for
+// a thread which blocks or exits, or lets the others run.
+void yield();
+
+// Log the state of the run queue of every cpu.
+void dump_statistics();
 
 libruntime::RefPtr<system::tasking::Thread> running_thread();
 
+// Whether the thread is running on an other cpu than ours. It's only compared
+// to the running threads, so it may already be gone.
+bool is_running_on_other_cpu(system::tasking::Thread *thread);
+
 libruntime::RefPtr<system::tasking::Process> running_process();
 
 } // namespace system::scheduling
@@ -0,0 +1,212 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libmath/MinMax.h>
+#include <libruntime/TicketLock.h>
+
+#include "arch/Arch.h"
+#include "system/System.h"
+#include "system/scheduling/Timer.h"
+
+namespace system::scheduling
+{
+
+static libruntime::TicketLock _lock;
+static Timer *_buckets[TIMER_WHEEL_SIZE];
+
+// The last tick whose bucket was expired, a new deadline must come after it
+// or it would wait for a whole turn of the wheel.
+static uint64_t _expired_tick;
+
+// The timer whose callback each cpu is running, several cpus may be
+// expiring timers at the same time.
+static Timer *_firing[MAX_CPU_COUNT];
+
+static bool lock()
+{
+    return _lock.acquire_irqsave();
+}
+
+static void unlock(bool were_enabled)
+{
+    _lock.release_irqrestore(were_enabled);
+}
+
+// Must be called with the lock held.
+static bool is_firing_on_other_cpu(Timer *timer)
+{
+    int current_cpu = arch::get_current_cpu();
+
+    for (int cpu = 0; cpu < MAX_CPU_COUNT; cpu++)
+    {
+        if (cpu != current_cpu && _firing[cpu] == timer)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static Timer *&bucket_of(uint64_t deadline)
+{
+    return _buckets[deadline & (TIMER_WHEEL_SIZE - 1)];
+}
+
+// Must be called with the lock held.
+void Timer::link()
+{
+    Timer *&bucket = bucket_of(_deadline);
+
+    _prev = nullptr;
+    _next = bucket;
+
+    if (bucket)
+    {
+        bucket->_prev = this;
+    }
+
+    bucket = this;
+    _linked = true;
+}
+
+// Must be called with the lock held.
+void Timer::unlink()
+{
+    if (!_linked)
+    {
+        return;
+    }
+
+    if (_prev)
+    {
+        _prev->_next = _next;
+    }
+    else
+    {
+        bucket_of(_deadline) = _next;
+    }
+
+    if (_next)
+    {
+        _next->_prev = _prev;
+    }
+
+    _prev = nullptr;
+    _next = nullptr;
+    _linked = false;
+}
+
+void Timer::arm(uint64_t delay, uint64_t period)
+{
+    bool were_enabled = lock();
+
+    unlink();
+
+    _deadline = libmath::max(system::get_tick() + libmath::max(delay, (uint64_t)1), _expired_tick + 1);
+    _period = period;
+    _armed = true;
+
+    link();
+
+    unlock(were_enabled);
+}
+
+void Timer::cancel()
+{
+    bool were_enabled = lock();
+
+    unlink();
+    _armed = false;
+
+    // Wait for the callback to return, unless we are called from it.
+    while (is_firing_on_other_cpu(this))
+    {
+        unlock(were_enabled);
+        were_enabled = lock();
+    }
+
+    unlock(were_enabled);
+}
+
+uint64_t next_timer_deadline()
+{
+    bool were_enabled = lock();
+
+    uint64_t result = _expired_tick + TIMER_WHEEL_SIZE;
+
+    // Only one turn of the wheel is looked at, the cpu will wake up at the
+    // end of it anyway.
+    for (uint64_t tick = _expired_tick + 1; tick < _expired_tick + TIMER_WHEEL_SIZE; tick++)
+    {
+        Timer *timer = bucket_of(tick);
+
+        while (timer && timer->_deadline > tick)
+        {
+            timer = timer->_next;
+        }
+
+        if (timer)
+        {
+            result = tick;
+            break;
+        }
+    }
+
+    unlock(were_enabled);
+
+    return result;
+}
+
+void expire_timers(uint64_t tick)
+{
+    bool were_enabled = lock();
+
+    int cpu = arch::get_current_cpu();
+
+    _expired_tick = libmath::max(_expired_tick, tick);
+
+    // Timers are taken one by one, the lock is released while a callback
+    // runs and the others may be canceled or restarted in the mean time.
+    while (true)
+    {
+        Timer *timer = bucket_of(tick);
+
+        while (timer && timer->_deadline > tick)
+        {
+            timer = timer->_next;
+        }
+
+        if (!timer)
+        {
+            break;
+        }
+
+        timer->unlink();
+
+        if (timer->_period == 0)
+        {
+            timer->_armed = false;
+        }
+
+        _firing[cpu] = timer;
+
+        unlock(were_enabled);
+        timer->_callback(timer->_data);
+        were_enabled = lock();
+
+        _firing[cpu] = nullptr;
+
+        // Still armed and not restarted by its callback.
+        if (timer->_armed && !timer->_linked)
+        {
+            timer->_deadline += timer->_period;
+            timer->link();
+        }
+    }
+
+    unlock(were_enabled);
+}
+
+} // namespace system::scheduling
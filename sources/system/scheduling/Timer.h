@@ -0,0 +1,73 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Macros.h>
+#include <libruntime/Types.h>
+
+namespace system::scheduling
+{
+
+// Timers are hashed by deadline into the buckets of the wheel, a tick only
+// looks at its own bucket. Must be a power of two.
+#define TIMER_WHEEL_SIZE 256
+
+typedef void (*TimerCallback)(void *data);
+
+// A one-shot or periodic callback, deadlines are in ticks. Callbacks run from
+// the clock interrupt of the cpu which brings the tick count up to date,
+// without any lock held.
+class Timer
+{
+private:
+    TimerCallback _callback;
+    void *_data;
+
+    uint64_t _deadline = 0;
+    uint64_t _period = 0;
+    bool _armed = false;
+
+    // Linked in the bucket of the wheel.
+    bool _linked = false;
+    Timer *_prev = nullptr;
+    Timer *_next = nullptr;
+
+    void link();
+    void unlink();
+    void arm(uint64_t delay, uint64_t period);
+
+    friend uint64_t next_timer_deadline();
+    friend void expire_timers(uint64_t tick);
+
+public:
+    bool armed() { return _armed; }
+    uint64_t deadline() { return _deadline; }
+
+    Timer(TimerCallback callback, void *data) : _callback(callback), _data(data) {}
+
+    ~Timer() { cancel(); }
+
+    __noncopyable(Timer);
+    __nonmovable(Timer);
+
+    // Call the callback once, in at least `delay` ticks.
+    void start(uint64_t delay) { arm(delay, 0); }
+
+    // Call the callback every `period` ticks until the timer is canceled.
+    void start_periodic(uint64_t period) { arm(period, period); }
+
+    // Once it returns the callback is not running and won't run again, unless
+    // the timer is started again. It can be called from the callback itself,
+    // but the timer must not be destroyed from there.
+    void cancel();
+};
+
+// The earliest tick with a timer to expire, a cpu can sleep until then.
+uint64_t next_timer_deadline();
+
+// Run the timers which are due, called by system::tick() for every tick.
+void expire_timers(uint64_t tick);
+
+} // namespace system::scheduling
@@ -0,0 +1,111 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include "arch/Arch.h"
+#include "system/scheduling/Scheduling.h"
+#include "system/scheduling/WaitQueue.h"
+
+namespace system::scheduling
+{
+
+BlockerWait *WaitQueue::enqueue_running_thread()
+{
+    auto blocker = new BlockerWait(running_thread().necked(), _type);
+
+    bool were_enabled = arch::disable_interrupts();
+    _lock.acquire();
+
+    _waiters.push_back(*blocker);
+
+    _lock.release();
+    arch::restore_interrupts(were_enabled);
+
+    return blocker;
+}
+
+void WaitQueue::wait()
+{
+    auto blocker = enqueue_running_thread();
+
+    running_thread()->block(blocker);
+}
+
+void WaitQueue::wait(Mutex &mutex)
+{
+    // Queued before the mutex is released, so a wake up can't slip in between.
+    auto blocker = enqueue_running_thread();
+
+    mutex.release();
+    running_thread()->block(blocker);
+    mutex.acquire();
+}
+
+void WaitQueue::wait_until(libruntime::Callback<bool()> condition)
+{
+    auto running = running_thread();
+
+    do
+    {
+        auto blocker = new BlockerWait(running.necked(), _type);
+
+        bool were_enabled = arch::disable_interrupts();
+        _lock.acquire();
+
+        bool done = condition();
+
+        if (!done)
+        {
+            _waiters.push_back(*blocker);
+        }
+
+        _lock.release();
+        arch::restore_interrupts(were_enabled);
+
+        if (done)
+        {
+            delete blocker;
+
+            return;
+        }
+
+        running->block(blocker);
+    } while (true);
+}
+
+bool WaitQueue::wake_one()
+{
+    bool were_enabled = arch::disable_interrupts();
+    _lock.acquire();
+
+    if (_waiters.empty())
+    {
+        _lock.release();
+        arch::restore_interrupts(were_enabled);
+
+        return false;
+    }
+
+    BlockerWait *next = _waiters.pop();
+
+    // Take a reference before, the blocker may be freed as soon as the thread sees it.
+    libruntime::RefPtr<system::tasking::Thread> thread = *next->thread();
+    next->woken();
+
+    _lock.release();
+
+    wakeup(thread);
+
+    arch::restore_interrupts(were_enabled);
+
+    return true;
+}
+
+void WaitQueue::wake_all()
+{
+    while (wake_one())
+    {
+    }
+}
+
+} // namespace system::scheduling
@@ -0,0 +1,58 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Callback.h>
+#include <libruntime/IntrusiveList.h>
+#include <libruntime/Macros.h>
+#include <libruntime/SpinLock.h>
+
+#include "system/scheduling/BlockerWait.h"
+#include "system/scheduling/Mutex.h"
+
+namespace system::scheduling
+{
+
+// Threads sleeping until something happen, woken up in FIFO order. The time
+// they spend in it is accounted as blocked on the type of the queue.
+class WaitQueue
+{
+private:
+    BlockerType _type;
+
+    libruntime::SpinLock _lock;
+    libruntime::IntrusiveList<BlockerWait, &BlockerWait::node> _waiters;
+
+    BlockerWait *enqueue_running_thread();
+
+public:
+    WaitQueue() : _type(BlockerType::WAIT) {}
+
+    WaitQueue(BlockerType type) : _type(type) {}
+
+    ~WaitQueue() {}
+
+    __noncopyable(WaitQueue);
+    __nonmovable(WaitQueue);
+
+    // A wake up which happens before wait() is lost, so the caller must
+    // check for what it waits for in a way which can't race with it.
+    void wait();
+
+    // Release the mutex and wait, it is held again when this returns. Nothing
+    // is lost if the wake up is done with the mutex held.
+    void wait(Mutex &mutex);
+
+    // Wait until the condition is true. It's checked with the queue locked,
+    // so whoever makes it true before waking the queue up can't be missed.
+    void wait_until(libruntime::Callback<bool()> condition);
+
+    // Return false if nobody was waiting.
+    bool wake_one();
+
+    void wake_all();
+};
+
+} // namespace system::scheduling
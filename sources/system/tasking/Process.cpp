@@ -2,7 +2,8 @@
 /* This code is licensed under the 3-Clause BSD License.                      */
 /* See: LICENSE.md                                                            */
 
-#include <libruntime/SpinLock.h>
+#include <libruntime/IntrusiveList.h>
+#include <libruntime/TicketLock.h>
 #include <libsystem/Logger.h>
 
 #include "arch/Arch.h"
@@ -12,17 +13,26 @@ namespace system::tasking
 {
 
 static int _process_id_counter = -1;
-static libruntime::SpinLock _processes_lock;
-static libruntime::LinkedList<libruntime::RefPtr<Process>> _processes;
+// Like threads, processes are in the registry for their whole life, and may
+// be destroyed from the scheduler.
+static libruntime::TicketLock _processes_lock;
+static libruntime::IntrusiveList<Process, &Process::registry_node> _processes;
 
 Process::Process(libruntime::String name)
     : _id(__atomic_add_fetch(&_process_id_counter, 1, __ATOMIC_SEQ_CST)),
-      _name(name)
+      _name(name),
+      _address_space(arch::create_address_space())
 {
+    bool were_enabled = _processes_lock.acquire_irqsave();
+    _processes.push_back(*this);
+    _processes_lock.release_irqrestore(were_enabled);
 }
 
 Process::~Process()
 {
+    bool were_enabled = _processes_lock.acquire_irqsave();
+    _processes.remove(*this);
+    _processes_lock.release_irqrestore(were_enabled);
 }
 
 libruntime::ErrorOr<size_t> Process::format(libsystem::Stream &stream, libsystem::FormatInfo &info)
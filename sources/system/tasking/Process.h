@@ -4,10 +4,9 @@
 /* This code is licensed under the 3-Clause BSD License.                      */
 /* See: LICENSE.md                                                            */
 
-#include <libruntime/LinkedList.h>
+#include <libruntime/IntrusiveList.h>
 #include <libruntime/RefPtr.h>
 #include <libruntime/String.h>
-#include <libruntime/LinkedList.h>
 #include <libsystem/Formattable.h>
 
 #include "system/memory/AddressSpace.h"
@@ -27,6 +26,9 @@ private:
     libruntime::OwnPtr<memory::AddressSpace> _address_space;
 
 public:
+    // Link the process in the registry for its whole life.
+    libruntime::IntrusiveListNode registry_node;
+
     int id() { return _id; }
     libruntime::String name() { return _name; }
     Promotion promotion() { return _promotion; }
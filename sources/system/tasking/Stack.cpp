@@ -0,0 +1,188 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libc/string.h>
+#include <libruntime/TicketLock.h>
+#include <libsystem/Assert.h>
+
+#include "arch/Arch.h"
+#include "system/System.h"
+#include "system/memory/Memory.h"
+#include "system/tasking/Stack.h"
+
+namespace system::tasking
+{
+
+// The stack region is cut in slots, a guard page followed by a stack. Slots
+// are mapped the first time they are used and never unmapped, free stacks
+// are kept in a cache on each cpu, and the ones which don't fit there in a
+// global list going through the first word of each stack. Once every slot is
+// in use, no more stack can be taken until one is given back.
+struct StackCache
+{
+    size_t count;
+    uintptr_t stacks[STACK_CACHE_DEPTH];
+};
+
+static StackCache _caches[MAX_CPU_COUNT];
+
+static libruntime::TicketLock _lock;
+static uintptr_t _free_stacks;
+static size_t _slot_count;
+
+static size_t stack_size()
+{
+    return STACK_PAGE_COUNT * arch::get_page_size();
+}
+
+static size_t slot_size()
+{
+    return (STACK_GUARD_PAGE_COUNT + STACK_PAGE_COUNT) * arch::get_page_size();
+}
+
+static size_t slot_count_max()
+{
+    return arch::get_kernel_stack_region().size() / slot_size();
+}
+
+static StackCache &current_cache()
+{
+    int cpu = arch::get_current_cpu();
+
+    assert(cpu < MAX_CPU_COUNT);
+
+    return _caches[cpu];
+}
+
+static uintptr_t map_stack(size_t slot, memory::MemoryRegion pages)
+{
+    auto region = arch::get_kernel_stack_region();
+
+    uintptr_t base = region.base_address() + slot * slot_size() + STACK_GUARD_PAGE_COUNT * arch::get_page_size();
+
+    for (size_t i = 0; i < STACK_PAGE_COUNT; i++)
+    {
+        arch::map_kernel_stack_page(base + i * arch::get_page_size(), pages.base_address() + i * arch::get_page_size());
+    }
+
+    libc::memset(reinterpret_cast<void *>(base), 0, stack_size());
+
+    return base;
+}
+
+// Must be called with _lock held, return 0 if there is no free stack.
+static uintptr_t pop_free_stack()
+{
+    uintptr_t stack = _free_stacks;
+
+    if (stack)
+    {
+        _free_stacks = *reinterpret_cast<uintptr_t *>(stack);
+        *reinterpret_cast<uintptr_t *>(stack) = 0;
+    }
+
+    return stack;
+}
+
+// Return 0 if every slot is in use, or if there is no memory left to map a new one.
+static uintptr_t take_stack()
+{
+    bool were_enabled = arch::disable_interrupts();
+
+    StackCache &cache = current_cache();
+
+    if (cache.count > 0)
+    {
+        uintptr_t stack = cache.stacks[--cache.count];
+        arch::restore_interrupts(were_enabled);
+
+        return stack;
+    }
+
+    _lock.acquire();
+    uintptr_t stack = pop_free_stack();
+    bool is_full = _slot_count >= slot_count_max();
+    _lock.release();
+    arch::restore_interrupts(were_enabled);
+
+    if (stack || is_full)
+    {
+        return stack;
+    }
+
+    // The pages are taken before the slot, so a slot is never left unmapped.
+    auto pages = memory::try_alloc_region(STACK_PAGE_COUNT);
+
+    if (pages.is_empty())
+    {
+        return 0;
+    }
+
+    // An other cpu may have given a stack back or taken the last slot meanwhile.
+    were_enabled = arch::disable_interrupts();
+    _lock.acquire();
+
+    stack = pop_free_stack();
+    bool has_slot = false;
+    size_t slot = 0;
+
+    if (!stack && _slot_count < slot_count_max())
+    {
+        has_slot = true;
+        slot = _slot_count++;
+    }
+
+    _lock.release();
+    arch::restore_interrupts(were_enabled);
+
+    if (has_slot)
+    {
+        stack = map_stack(slot, pages);
+    }
+    else
+    {
+        memory::free_region(pages);
+    }
+
+    return stack;
+}
+
+static void give_stack(uintptr_t stack)
+{
+    libc::memset(reinterpret_cast<void *>(stack), 0, stack_size());
+
+    bool were_enabled = arch::disable_interrupts();
+
+    StackCache &cache = current_cache();
+
+    if (cache.count < STACK_CACHE_DEPTH)
+    {
+        cache.stacks[cache.count++] = stack;
+    }
+    else
+    {
+        _lock.acquire();
+        *reinterpret_cast<uintptr_t *>(stack) = _free_stacks;
+        _free_stacks = stack;
+        _lock.release();
+    }
+
+    arch::restore_interrupts(were_enabled);
+}
+
+Stack::Stack()
+{
+    _base = take_stack();
+    _ptr = _base ? _base + stack_size() : 0;
+}
+
+Stack::~Stack()
+{
+    if (_base)
+    {
+        give_stack(_base);
+    }
+}
+
+} // namespace system::tasking
@@ -5,30 +5,38 @@
 /* See: LICENSE.md                                                            */
 
 #include <libc/string.h>
+#include <libruntime/Macros.h>
 #include <libruntime/Types.h>
 
-#include "system/memory/Memory.h"
-
 namespace system::tasking
 {
 
+#define STACK_PAGE_COUNT 16
+#define STACK_GUARD_PAGE_COUNT 1
+
+// Kernel stacks that a cpu keeps for itself before giving them to the others.
+#define STACK_CACHE_DEPTH 4
+
+// A kernel stack, mapped in the stack region of every address space with an
+// unmapped guard page right below it, so an overflow faults instead of
+// writing over something else. Stacks are zeroed when they are given back,
+// a new one is ready to use.
 class Stack
 {
 private:
     uintptr_t _ptr;
-    memory::MemoryRegion _region;
+    uintptr_t _base;
 
 public:
-    Stack(size_t how_many_pages)
-    {
-        _region = memory::alloc_region(how_many_pages);
-        _ptr = _region.end_address();
-    }
+    Stack();
 
-    ~Stack()
-    {
-        memory::free_region(_region);
-    }
+    ~Stack();
+
+    __noncopyable(Stack);
+    __nonmovable(Stack);
+
+    // False if the stack region or physical memory was full, nothing can be pushed on it.
+    bool allocated() { return _base != 0; }
 
     template <typename T>
     uintptr_t push(T value)
@@ -54,6 +62,12 @@ public:
     {
         _ptr = ptr;
     }
+
+    // Where a context switch saves the stack pointer.
+    uintptr_t *get_pointer_address(void)
+    {
+        return &_ptr;
+    }
 };
 
 } // namespace system::tasking
@@ -1,9 +1,14 @@
 
+#include <libmath/Divide.h>
 #include <libsystem/Logger.h>
 
 #include "arch/Arch.h"
-#include "system/tasking/Tasking.h"
+#include "system/scheduling/Mutex.h"
+#include "system/scheduling/PolicyIdle.h"
+#include "system/System.h"
+#include "system/scheduling/Scheduling.h"
 #include "system/tasking/Process.h"
+#include "system/tasking/Tasking.h"
 
 namespace system::tasking
 {
@@ -18,6 +23,61 @@ static void idle_task_code()
 
 static libruntime::RefPtr<Process> _kernel_process;
 
+libruntime::RefPtr<Thread> create_idle_thread(int cpu)
+{
+    auto new_thread = tasking::Thread::create(_kernel_process, idle_task_code);
+    assert(new_thread.succeed());
+
+    auto idle_thread = new_thread.value();
+    idle_thread->set_policy(libruntime::own<scheduling::PolicyIdle>());
+
+    scheduling::set_idle_thread(cpu, idle_thread);
+    idle_thread->start();
+
+    return idle_thread;
+}
+
+// The walk is long and only done by threads, the others wanting to dump
+// sleep until it's done, so the lines of two dumps aren't mixed.
+static scheduling::Mutex _dump_lock;
+
+void dump_threads()
+{
+    _dump_lock.acquire();
+
+    logger_info("thread  state  cpu  cpu%  run(ms)  ready(ms)  latency(us)  sleep(ms)  mutex(ms)  wait(ms)  join(ms)  voluntary  involuntary");
+
+    Thread::foreach ([](auto thread) {
+        ThreadAccounting accounting = thread->accounting();
+
+        size_t cpu_percent = libmath::percent(accounting.running, arch::clock_cycles() - accounting.created);
+        size_t latency = cycles_to_microseconds(libmath::divide(accounting.ready, accounting.readied));
+
+        auto blocked_milliseconds = [&](scheduling::BlockerType type) {
+            return (size_t)cycles_to_milliseconds(accounting.blocked[static_cast<int>(type)]);
+        };
+
+        logger_info("{}  {}  {}  {}  {}  {}  {}  {}  {}  {}  {}  {}  {}",
+                    thread->id(),
+                    thread->state_string(),
+                    thread->cpu(),
+                    cpu_percent,
+                    (size_t)cycles_to_milliseconds(accounting.running),
+                    (size_t)cycles_to_milliseconds(accounting.ready),
+                    latency,
+                    blocked_milliseconds(scheduling::BlockerType::SLEEP),
+                    blocked_milliseconds(scheduling::BlockerType::MUTEX),
+                    blocked_milliseconds(scheduling::BlockerType::WAIT),
+                    blocked_milliseconds(scheduling::BlockerType::JOIN),
+                    accounting.voluntary_switches,
+                    accounting.involuntary_switches);
+
+        return libruntime::Iteration::CONTINUE;
+    });
+
+    _dump_lock.release();
+}
+
 void initialize()
 {
     logger_info("Initializing tasking");
@@ -25,10 +85,12 @@ void initialize()
     _kernel_process = libruntime::make<Process>("Kernel");
 
     // Create the main kernel thread...
-    tasking::Thread::create(_kernel_process, nullptr)->start();
+    auto main_thread = tasking::Thread::create(_kernel_process, nullptr);
+    assert(main_thread.succeed());
+    main_thread.value()->start();
 
-    // Create the idle task
-    tasking::Thread::create(_kernel_process, idle_task_code)->start();
+    // Create the idle task of the boot processor
+    create_idle_thread(arch::get_current_cpu());
 }
 
 libruntime::RefPtr<Process> kernel_process()
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "system/tasking/Process.h"
+#include "system/tasking/Thread.h"
 
 namespace system::tasking
 {
@@ -9,4 +10,10 @@ libruntime::RefPtr<Process> kernel_process();
 
 void initialize();
 
+// Create and start the thread which runs on the cpu when it has nothing else to do.
+libruntime::RefPtr<Thread> create_idle_thread(int cpu);
+
+// Log where the time of every thread went, like top would.
+void dump_threads();
+
 } // namespace system::tasking
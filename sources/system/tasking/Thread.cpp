@@ -2,37 +2,71 @@
 /* This code is licensed under the 3-Clause BSD License.                      */
 /* See: LICENSE.md                                                            */
 
-#include <libruntime/SpinLock.h>
+#include <libruntime/IntrusiveList.h>
+#include <libruntime/TicketLock.h>
 #include <libsystem/Assert.h>
 #include <libsystem/Formattable.h>
-#include <libsystem/Logger.h>
 
 #include "arch/Arch.h"
-#include "system/scheduling/BlockerJoin.h"
 #include "system/scheduling/BlockerSleep.h"
+#include "system/scheduling/PolicyNormal.h"
 #include "system/scheduling/Scheduling.h"
 #include "system/tasking/Thread.h"
+#include "system/trace/Trace.h"
 
 namespace system::tasking
 {
 
-static libruntime::SpinLock _threads_lock;
-static libruntime::LinkedList<libruntime::RefPtr<Thread>> _threads;
+// Every thread is in the registry from its construction to its destruction,
+// it doesn't hold references, so a thread nobody joins is destroyed once it
+// stops running. Entries are taken with try_ref(), like WeakPtr::strong()
+// does, without a weak link to allocate for each thread. That may happen in
+// the scheduler, so the lock is held with interrupts disabled, and only for
+// short walks.
+static libruntime::TicketLock _threads_lock;
+static libruntime::IntrusiveList<Thread, &Thread::registry_node> _threads;
 static volatile int _thread_id_counter;
 
+// Return the first thread from this one which isn't being destroyed, with a
+// reference taken on it. Must be called with _threads_lock held.
+static Thread *first_alive_thread(Thread *thread)
+{
+    while (thread && !thread->try_ref())
+    {
+        thread = _threads.next(*thread);
+    }
+
+    return thread;
+}
+
 Thread::Thread(libruntime::RefPtr<Process> process, ThreadEntry entry)
     : _id(__atomic_add_fetch(&_thread_id_counter, 1, __ATOMIC_SEQ_CST)),
       _entry(entry),
       _state(ThreadState::EMBRYO),
+      _cpu(0),
       _process(process),
-      _stack(16),
-      _userstack(16)
+      _policy(libruntime::own<scheduling::PolicyNormal>())
 {
+    _accounting.created = arch::clock_cycles();
+    _accounting.since = _accounting.created;
+
+    bool were_enabled = _threads_lock.acquire_irqsave();
+    _threads.push_back(*this);
+    _threads_lock.release_irqrestore(were_enabled);
 }
 
 Thread::~Thread()
 {
-    logger_info("Destructing {}...", this);
+    trace::record(trace::TraceEvent::THREAD_DESTROY, id());
+
+    bool were_enabled = _threads_lock.acquire_irqsave();
+    _threads.remove(*this);
+    _threads_lock.release_irqrestore(were_enabled);
+
+    if (_userstack != nullptr)
+    {
+        _process->address_space().unmap(_userstack);
+    }
 }
 
 #define THREAD_STATE_STRING_ENTRY(__x) #__x,
@@ -44,6 +78,75 @@ const char *Thread::state_string()
     return _state_string[static_cast<int>(_state)];
 }
 
+// Clocks of different cpus aren't exactly in sync, a thread which moved
+// may look like it went back in time.
+static uint64_t elapsed_since(uint64_t since, uint64_t now)
+{
+    return now > since ? now - since : 0;
+}
+
+static void account(ThreadAccounting &accounting, ThreadState state, scheduling::BlockerType blocked_on, uint64_t elapsed)
+{
+    switch (state)
+    {
+    case ThreadState::RUNNING:
+        accounting.running += elapsed;
+        break;
+
+    case ThreadState::READY:
+        accounting.ready += elapsed;
+        break;
+
+    case ThreadState::BLOCKED:
+        accounting.blocked[static_cast<int>(blocked_on)] += elapsed;
+        break;
+
+    default:
+        break;
+    }
+}
+
+void Thread::set_state(ThreadState state)
+{
+    uint64_t now = arch::clock_cycles();
+
+    account(_accounting, _state, _blocked_on, elapsed_since(_accounting.since, now));
+    _accounting.since = now;
+
+    if (state == ThreadState::READY && _state != ThreadState::READY)
+    {
+        _accounting.readied++;
+    }
+
+    if (state == ThreadState::BLOCKED && _blocker)
+    {
+        _blocked_on = _blocker->type();
+    }
+
+    _state = state;
+}
+
+ThreadAccounting Thread::accounting()
+{
+    ThreadAccounting accounting = _accounting;
+
+    account(accounting, _state, _blocked_on, elapsed_since(accounting.since, arch::clock_cycles()));
+
+    return accounting;
+}
+
+void Thread::account_switch(bool voluntary)
+{
+    if (voluntary)
+    {
+        _accounting.voluntary_switches++;
+    }
+    else
+    {
+        _accounting.involuntary_switches++;
+    }
+}
+
 void Thread::start()
 {
     assert(_state == ThreadState::EMBRYO);
@@ -53,15 +156,19 @@ void Thread::start()
     switch_state(ThreadState::READY);
 }
 
-// void Thread::set_policy(libruntime::OwnPtr<system::scheduling::Policy> policy)
-// {
-// }
+void Thread::set_policy(libruntime::OwnPtr<system::scheduling::Policy> policy)
+{
+    assert(_state == ThreadState::EMBRYO);
+
+    _policy = policy;
+}
 
 void Thread::block(libruntime::OwnPtr<system::scheduling::Blocker> blocker)
 {
     _blocker = blocker;
+    trace::record(trace::TraceEvent::BLOCK, id(), static_cast<uint32_t>(_blocker->type()));
     switch_state(ThreadState::BLOCKED);
-    arch::yield();
+    scheduling::yield();
 }
 
 void Thread::switch_state(ThreadState new_state)
@@ -91,24 +198,50 @@ libruntime::ErrorOr<size_t> Thread::format(libsystem::Stream &stream, libsystem:
     return libsystem::format(stream, "Thread(id={}, state={}, process={})", id(), state_string(), process());
 }
 
-libruntime::RefPtr<Thread> Thread::create(libruntime::RefPtr<Process> process, ThreadEntry entry)
+libruntime::ErrorOr<libruntime::RefPtr<Thread>> Thread::create(libruntime::RefPtr<Process> process, ThreadEntry entry)
 {
     auto new_thread = arch::create_thread(process, entry);
 
-    new_thread->prepare();
+    if (!new_thread->stack().allocated())
+    {
+        return libruntime::Error::OUT_OF_MEMORY;
+    }
+
+    if (new_thread->promotion() == Promotion::USER)
+    {
+        auto userstack = process->address_space().map(libruntime::make<memory::MemoryObject>(THREAD_USERSTACK_PAGE_COUNT));
+
+        if (!userstack.succeed())
+        {
+            return userstack.error();
+        }
 
-    _threads_lock.acquire();
-    _threads.push_back(new_thread);
-    _threads_lock.release();
+        new_thread->_userstack = userstack.value();
+    }
+
+    new_thread->prepare();
 
     return new_thread;
 }
 
 void Thread::exit()
 {
-    logger_info("{} kill himself.", scheduling::running_thread());
-    scheduling::update_thread_state(scheduling::running_thread(), ThreadState::STOPPED);
-    arch::yield();
+    // Never turned back on: preempted once STOPPED, we would never run
+    // again to wake the joiners up.
+    arch::disable_interrupts();
+
+    auto running = scheduling::running_thread();
+
+    trace::record(trace::TraceEvent::THREAD_EXIT, running->id());
+    scheduling::update_thread_state(running, ThreadState::STOPPED);
+
+    // Joiners check the state with the queue locked, none can be missed.
+    running->_joiners.wake_all();
+
+    // We never come back from yield(), don't keep a reference on ourself.
+    running = nullptr;
+
+    scheduling::yield();
     assert_not_reached();
 }
 
@@ -116,8 +249,9 @@ void Thread::sleep(libsystem::Millisecond time)
 {
     if (time > 0)
     {
-        logger_info("{} is going to sleep for {}ms", scheduling::running_thread(), time);
-        scheduling::running_thread()->block(new system::scheduling::BlockerSleep(time));
+        auto running = scheduling::running_thread();
+
+        running->block(new system::scheduling::BlockerSleep(running.necked(), time));
     }
 }
 
@@ -125,23 +259,21 @@ void Thread::join(libruntime::RefPtr<Thread> thread_to_join)
 {
     assert(thread_to_join != nullptr);
 
-    if (thread_to_join->state() != ThreadState::STOPPED)
-    {
-        logger_info("{} is joining {}", scheduling::running_thread(), thread_to_join);
-        scheduling::running_thread()->block(new system::scheduling::BlockerJoin(thread_to_join));
-    }
+    thread_to_join->_joiners.wait_until([&]() {
+        return thread_to_join->state() == ThreadState::STOPPED;
+    });
 }
 
 libruntime::RefPtr<Thread> Thread::by_id(int id)
 {
-    libruntime::RefPtr<Thread> result;
+    Thread *result = nullptr;
 
-    _threads_lock.acquire();
+    bool were_enabled = _threads_lock.acquire_irqsave();
 
-    _threads.foreach ([&](auto thread) {
-        if (thread->id() == id)
+    _threads.foreach ([&](Thread &thread) {
+        if (thread.id() == id && thread.try_ref())
         {
-            result = thread;
+            result = &thread;
 
             return libruntime::Iteration::STOP;
         }
@@ -149,29 +281,37 @@ libruntime::RefPtr<Thread> Thread::by_id(int id)
         return libruntime::Iteration::CONTINUE;
     });
 
-    _threads_lock.release();
-
-    return result;
-}
+    _threads_lock.release_irqrestore(were_enabled);
 
-void Thread::cleanup(libruntime::RefPtr<Thread> thread)
-{
-    assert(thread != nullptr);
+    if (!result)
+    {
+        return nullptr;
+    }
 
-    _threads_lock.acquire();
-    _threads.remove(thread);
-    _threads_lock.release();
+    return libruntime::adopt(*result);
 }
 
-void Thread::foreach (libruntime::Callback<libruntime::Iteration(libruntime::RefPtr<Thread>)> callback)
+// The lock isn't held while the callback runs, the reference we hold keep the
+// current thread in the registry, and so where we are in it.
+void Thread::foreach (libruntime::Callback<libruntime::Iteration(libruntime::RefPtrView<Thread>)> callback)
 {
-    _threads_lock.acquire();
+    bool were_enabled = _threads_lock.acquire_irqsave();
+    Thread *thread = first_alive_thread(_threads.first());
+    _threads_lock.release_irqrestore(were_enabled);
 
-    _threads.foreach ([&](auto thread) {
-        return callback(thread);
-    });
+    while (thread)
+    {
+        auto current = libruntime::adopt(*thread);
 
-    _threads_lock.release();
+        if (callback(current) == libruntime::Iteration::STOP)
+        {
+            return;
+        }
+
+        were_enabled = _threads_lock.acquire_irqsave();
+        thread = first_alive_thread(_threads.next(*current));
+        _threads_lock.release_irqrestore(were_enabled);
+    }
 }
 
 } // namespace system::tasking
@@ -5,13 +5,16 @@
 /* See: LICENSE.md                                                            */
 
 #include <libruntime/Callback.h>
+#include <libruntime/IntrusiveList.h>
 #include <libruntime/OwnPtr.h>
 #include <libruntime/RefCounted.h>
+#include <libsystem/Assert.h>
 #include <libsystem/Time.h>
 
 #include "system/platform/Context.h"
 #include "system/scheduling/Blocker.h"
 #include "system/scheduling/Policy.h"
+#include "system/scheduling/WaitQueue.h"
 #include "system/tasking/Process.h"
 #include "system/tasking/Stack.h"
 
@@ -22,6 +25,9 @@ class Process;
 
 typedef void (*ThreadEntry)(void);
 
+// Only reserves address space, the pages of the user stack are allocated as it grows.
+#define THREAD_USERSTACK_PAGE_COUNT 256
+
 #define THREAD_STATE_LIST(__ENTRY) \
     __ENTRY(EMBRYO)                \
     __ENTRY(RUNNING)               \
@@ -36,29 +42,80 @@ enum class ThreadState
     THREAD_STATE_LIST(THREAD_STATE_ENUM_ENTRY) __COUNT
 };
 
+// Where the time of a thread went, in clock cycles. It's updated by whoever
+// changes the state of the thread, and read without locks.
+struct ThreadAccounting
+{
+    uint64_t created;
+    uint64_t since; // When the thread entered its current state.
+
+    uint64_t running;
+    uint64_t ready;
+    uint64_t blocked[static_cast<int>(system::scheduling::BlockerType::__COUNT)];
+
+    // How many times it was made ready, the average scheduler latency is ready / readied.
+    size_t readied;
+
+    // Blocked, exited or yielded, versus preempted.
+    size_t voluntary_switches;
+    size_t involuntary_switches;
+};
+
 class Thread : public libruntime::RefCounted<Thread>, public libsystem::Formattable
 {
 private:
     int _id;
     ThreadEntry _entry;
     ThreadState _state;
+    int _cpu;
     libruntime::RefPtr<Process> _process;
     Stack _stack;
-    Stack _userstack;
+    libruntime::RefPtr<memory::MemoryMapping> _userstack;
 
     libruntime::OwnPtr<system::scheduling::Policy> _policy;
     libruntime::OwnPtr<system::scheduling::Blocker> _blocker;
 
+    ThreadAccounting _accounting = {};
+    system::scheduling::BlockerType _blocked_on = system::scheduling::BlockerType::SLEEP;
+
+    // Threads waiting for this one to exit.
+    system::scheduling::WaitQueue _joiners{system::scheduling::BlockerType::JOIN};
+
 public:
+    // Link the thread in the run queue of its cpu while it's ready.
+    libruntime::IntrusiveListNode queue_node;
+
+    // Link the thread in the registry for its whole life.
+    libruntime::IntrusiveListNode registry_node;
+
     int id() { return _id; }
     ThreadEntry entry() { return _entry; }
     ThreadState state() { return _state; }
     const char *state_string();
-    void set_state(ThreadState state) { _state = state; }
+    // Every state change goes through here, so it's accounted for.
+    void set_state(ThreadState state);
+
+    // A copy of the accounting, with the time spent in the current state so far.
+    ThreadAccounting accounting();
+
+    // Called by the scheduler when the thread stops running on its cpu.
+    void account_switch(bool voluntary);
+
+    // The cpu the thread last ran on, or whose run queue it's in.
+    int cpu() { return _cpu; }
+    void set_cpu(int cpu) { _cpu = cpu; }
+
+    system::scheduling::Policy &policy() { return *_policy; }
+    system::scheduling::Blocker &blocker() { return *_blocker; }
 
     Stack &stack() { return _stack; }
-    Stack &userstack() { return _userstack; }
-    libruntime::RefPtr<Process> process() { return _process; }
+    // Only user threads have a user stack. It's demand paged, nothing should be written to it from here.
+    uintptr_t userstack_top()
+    {
+        assert(_userstack != nullptr);
+        return _userstack->virtual_region().end_address();
+    }
+    libruntime::RefPtr<Process> &process() { return _process; }
     Promotion promotion() { return _process->promotion(); }
 
     Thread(libruntime::RefPtr<Process> process, ThreadEntry entry);
@@ -68,6 +125,7 @@ public:
     virtual void finalize() = 0;
 
     void start();
+    // Must be called before the thread is started.
     void set_policy(libruntime::OwnPtr<system::scheduling::Policy> policy);
     void block(libruntime::OwnPtr<system::scheduling::Blocker> blocker);
     void switch_state(ThreadState new_state);
@@ -75,15 +133,15 @@ public:
     bool should_unblock();
     void unblock();
 
-    static libruntime::RefPtr<Thread> create(libruntime::RefPtr<Process> process, ThreadEntry entry);
+    // Fail with OUT_OF_MEMORY if no kernel stack can be had, or with the error
+    // of the address space if the user stack can't be mapped.
+    static libruntime::ErrorOr<libruntime::RefPtr<Thread>> create(libruntime::RefPtr<Process> process, ThreadEntry entry);
     static void exit() __noreturn;
     static void sleep(libsystem::Millisecond time);
     static void join(libruntime::RefPtr<Thread> thread);
     static libruntime::RefPtr<Thread> by_id(int id);
 
-    // Release all the ressources hold by this thread
-    static void cleanup(libruntime::RefPtr<Thread> thread);
-    static void foreach (libruntime::Callback<libruntime::Iteration(libruntime::RefPtr<Thread>)> callback);
+    static void foreach (libruntime::Callback<libruntime::Iteration(libruntime::RefPtrView<Thread>)> callback);
 
     libruntime::ErrorOr<size_t> format(libsystem::Stream &stream, libsystem::FormatInfo &info);
 };
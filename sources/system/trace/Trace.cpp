@@ -0,0 +1,225 @@
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include "system/trace/Trace.h"
+
+#ifdef __CONFIG_TRACE__
+
+#    include <libsystem/Assert.h>
+#    include <libsystem/Logger.h>
+#    include <libsystem/Stdio.h>
+
+#    include "arch/Arch.h"
+#    include "system/System.h"
+#    include "system/tasking/Tasking.h"
+
+namespace system::trace
+{
+
+// Records per cpu, must be a power of two.
+#    define TRACE_RING_SIZE 1024
+
+#    define TRACE_DRAIN_INTERVAL 10
+
+static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0);
+static_assert(sizeof(TraceRecord) == 24);
+
+// Written by its cpu with interrupts disabled, read by the drainer from any
+// cpu, so one producer and one consumer and no lock: head is only moved by
+// the producer, tail by the consumer. Both count forever and wrap around.
+//
+// All zero is a valid empty ring.
+struct TraceRing
+{
+    uint32_t head;
+    uint32_t tail;
+    uint32_t dropped;
+
+    TraceRecord records[TRACE_RING_SIZE];
+};
+
+static bool _enabled = false;
+static TraceRing _rings[MAX_CPU_COUNT];
+
+// Only touched by the drainer.
+static uint32_t _reported_dropped[MAX_CPU_COUNT];
+static uint32_t _reported_clock;
+
+void record(TraceEvent event, uint32_t arg0, uint32_t arg1, uint32_t arg2)
+{
+    if (!_enabled)
+    {
+        return;
+    }
+
+    bool were_enabled = arch::disable_interrupts();
+
+    TraceRing &ring = _rings[arch::get_current_cpu()];
+
+    uint32_t head = ring.head;
+    uint32_t tail = __atomic_load_n(&ring.tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail >= TRACE_RING_SIZE)
+    {
+        __atomic_store_n(&ring.dropped, ring.dropped + 1, __ATOMIC_RELAXED);
+    }
+    else
+    {
+        TraceRecord &record = ring.records[head & (TRACE_RING_SIZE - 1)];
+
+        record.timestamp = arch::clock_cycles();
+        record.event = event;
+        record.args[0] = arg0;
+        record.args[1] = arg1;
+        record.args[2] = arg2;
+
+        // Publish the record only once it's written.
+        __atomic_store_n(&ring.head, head + 1, __ATOMIC_RELEASE);
+    }
+
+    arch::restore_interrupts(were_enabled);
+}
+
+// Lines are built whole and written at once, the log isn't locked and
+// anything else written to it would cut through them.
+struct TraceLine
+{
+    char buffer[80];
+    size_t length;
+
+    void append(const char *string)
+    {
+        for (size_t i = 0; string[i]; i++)
+        {
+            append(string[i]);
+        }
+    }
+
+    void append(char c)
+    {
+        assert(length < sizeof(buffer));
+
+        buffer[length++] = c;
+    }
+
+    void append_decimal(uint32_t value)
+    {
+        char digits[10];
+        size_t count = 0;
+
+        do
+        {
+            digits[count++] = '0' + value % 10;
+            value /= 10;
+        } while (value);
+
+        while (count)
+        {
+            append(digits[--count]);
+        }
+    }
+
+    void append_hex(const void *data, size_t size)
+    {
+        static const char *digits = "0123456789abcdef";
+        auto *bytes = reinterpret_cast<const uint8_t *>(data);
+
+        for (size_t i = 0; i < size; i++)
+        {
+            append(digits[bytes[i] >> 4]);
+            append(digits[bytes[i] & 0xf]);
+        }
+    }
+
+    void flush()
+    {
+        append('\n');
+        libsystem::stdlog->write(buffer, length);
+        length = 0;
+    }
+};
+
+static void drain_clock()
+{
+    uint32_t cycles_per_tick = arch::clock_cycles_per_tick();
+
+    if (cycles_per_tick != _reported_clock)
+    {
+        TraceLine line{};
+        line.append(TRACE_LINE_CLOCK " ");
+        line.append_decimal(cycles_per_tick * (TICK_FREQUENCY / 1000));
+        line.flush();
+
+        _reported_clock = cycles_per_tick;
+    }
+}
+
+static void drain_ring(int cpu)
+{
+    TraceRing &ring = _rings[cpu];
+
+    uint32_t head = __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE);
+    uint32_t tail = ring.tail;
+
+    while (tail != head)
+    {
+        TraceRecord record = ring.records[tail & (TRACE_RING_SIZE - 1)];
+
+        // The slot can be reused as soon as it's copied, not after the slow
+        // write to the serial port.
+        tail++;
+        __atomic_store_n(&ring.tail, tail, __ATOMIC_RELEASE);
+
+        TraceLine line{};
+        line.append(TRACE_LINE_RECORD " ");
+        line.append_decimal(cpu);
+        line.append(' ');
+        line.append_hex(&record, sizeof(record));
+        line.flush();
+    }
+
+    uint32_t dropped = __atomic_load_n(&ring.dropped, __ATOMIC_RELAXED);
+
+    if (dropped != _reported_dropped[cpu])
+    {
+        TraceLine line{};
+        line.append(TRACE_LINE_DROPPED " ");
+        line.append_decimal(cpu);
+        line.append(' ');
+        line.append_decimal(dropped - _reported_dropped[cpu]);
+        line.flush();
+
+        _reported_dropped[cpu] = dropped;
+    }
+}
+
+static void drain_task()
+{
+    do
+    {
+        drain_clock();
+
+        for (int cpu = 0; cpu < MAX_CPU_COUNT; cpu++)
+        {
+            drain_ring(cpu);
+        }
+
+        tasking::Thread::sleep(TRACE_DRAIN_INTERVAL);
+    } while (true);
+}
+
+void initialize()
+{
+    logger_info("Initializing tracing");
+
+    _enabled = true;
+
+    auto drain_thread = tasking::Thread::create(tasking::kernel_process(), drain_task);
+    assert(drain_thread.succeed());
+    drain_thread.value()->start();
+}
+
+} // namespace system::trace
+
+#endif
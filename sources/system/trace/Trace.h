@@ -0,0 +1,39 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Macros.h>
+
+#include "system/trace/TraceRecord.h"
+
+namespace system::trace
+{
+
+#ifdef __CONFIG_TRACE__
+
+// Start the thread which drains the rings, nothing is recorded before.
+void initialize();
+
+// Append a record to the ring of the current cpu, never blocks nor allocates
+// and can be called from interrupts. It's dropped if the ring is full.
+void record(TraceEvent event, uint32_t arg0 = 0, uint32_t arg1 = 0, uint32_t arg2 = 0);
+
+#else
+
+// Compiled out, build with BUILD_TRACE=yes to enable tracing.
+
+inline void initialize() {}
+
+inline void record(TraceEvent event, uint32_t arg0 = 0, uint32_t arg1 = 0, uint32_t arg2 = 0)
+{
+    __unused(event);
+    __unused(arg0);
+    __unused(arg1);
+    __unused(arg2);
+}
+
+#endif
+
+} // namespace system::trace
@@ -0,0 +1,51 @@
+#pragma once
+
+/* Copyright © 2019-2020 N. Van Bossuyt.                                      */
+/* This code is licensed under the 3-Clause BSD License.                      */
+/* See: LICENSE.md                                                            */
+
+#include <libruntime/Macros.h>
+#include <libruntime/Types.h>
+
+// Shared by the kernel and the host decoder, so it must not depend on
+// anything else from the kernel.
+
+namespace system::trace
+{
+
+// Event, then what its arguments are.
+#define TRACE_EVENT_LIST(__ENTRY) \
+    __ENTRY(SWITCH)         /* from thread, to thread, state of the thread it's switching from */ \
+    __ENTRY(BLOCK)          /* thread, blocker type */                                            \
+    __ENTRY(WAKEUP)         /* thread, cpu it's queued on */                                      \
+    __ENTRY(THREAD_EXIT)    /* thread */                                                          \
+    __ENTRY(THREAD_DESTROY) /* thread */                                                          \
+    __ENTRY(PAGE_ALLOC)     /* base address, page count */                                        \
+    __ENTRY(PAGE_FREE)      /* base address, page count */                                        \
+    __ENTRY(IRQ_ENTER)      /* interrupt number */                                                \
+    __ENTRY(IRQ_EXIT)       /* interrupt number */
+
+#define TRACE_EVENT_ENUM_ENTRY(__x) __x,
+
+enum class TraceEvent : uint32_t
+{
+    TRACE_EVENT_LIST(TRACE_EVENT_ENUM_ENTRY) __COUNT
+};
+
+struct __packed TraceRecord
+{
+    uint64_t timestamp; // arch::clock_cycles()
+    TraceEvent event;
+    uint32_t args[3];
+};
+
+// The rings are drained to the serial log as text lines, among the rest of
+// the log, so they survive being interleaved with it:
+//   @trace <cpu> <the record in hexadecimal, in memory order>
+//   @trace-clock <cycles per millisecond>
+//   @trace-dropped <cpu> <records dropped since the last line>
+#define TRACE_LINE_RECORD "@trace"
+#define TRACE_LINE_CLOCK "@trace-clock"
+#define TRACE_LINE_DROPPED "@trace-dropped"
+
+} // namespace system::trace
@@ -115,6 +115,26 @@ void memory_free(uintptr_t addr, size_t how_many_pages)
     __unused(how_many_pages);
 }
 
+/* --- Processor ------------------------------------------------------------ */
+
+// Userspace programs are single threaded for now, so there is nothing to
+// protect against and only one cache is ever used.
+
+bool interrupts_disable()
+{
+    return false;
+}
+
+void interrupts_restore(bool were_enabled)
+{
+    __unused(were_enabled);
+}
+
+size_t current_cpu()
+{
+    return 0;
+}
+
 /* --- Assert --------------------------------------------------------------- */
 
 void assert_failled()